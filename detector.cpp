@@ -34,6 +34,23 @@
 ****************************************************************************/
 
 #include <detector.h>
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <climits>
+#include <set>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /*
 //________________OPEN CV LIBRARIES___________________
@@ -68,6 +85,132 @@ bool generateLockTableEvaluationDetector() // Here we fill NPD_VALUES_FOR_EVALUA
 
 static bool flagFill = generateLockTableEvaluationDetector(); // This ensures that NPD_VALUES_FOR_EVALUATION is filled when the program starts
 
+/*A value (p1 - p2) / (p1 + p2) reached by some pair of pixels, stored as the irreducible fraction n / d together with one of those pairs*/
+class NPD_RATIO {
+  public: NPD_RATIO(int n, int d, int p1, int p2): n(n),
+  d(d),
+  p1(p1),
+  p2(p2) {}
+  int n;
+  int d;
+  int p1;
+  int p2;
+  bool operator < (const NPD_RATIO & r) const {
+    return n * r.d < r.n * d;
+  }
+  bool operator == (const NPD_RATIO & r) const {
+    return n == r.n && d == r.d;
+  }
+};
+
+static int greatestCommonDivisor(int a, int b) {
+  while (b != 0) {
+    int r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+/*Returns the distinct values of (p1 - p2) / (p1 + p2) for all the pairs of pixels except (0, 0), in increasing order*/
+static
+const std::vector < NPD_RATIO > & getNpdRatios() {
+
+  static std::vector < NPD_RATIO > ratios;
+
+  if (ratios.empty()) {
+    for (int p1 = 0; p1 < pixelResolution; p1++) {
+      for (int p2 = 0; p2 < pixelResolution; p2++) {
+        if (p1 == 0 && p2 == 0) continue;
+        int g = greatestCommonDivisor(std::abs(p1 - p2), p1 + p2);
+        ratios.push_back(NPD_RATIO((p1 - p2) / g, (p1 + p2) / g, p1, p2));
+      }
+    }
+    std::sort(ratios.begin(), ratios.end());
+    ratios.erase(std::unique(ratios.begin(), ratios.end()), ratios.end());
+  }
+
+  return ratios;
+}
+
+/*
+Converts the split test NPD_VALUES_FOR_EVALUATION[p1][p2] > threshold into the integer test a * p1 - b * p2 > c that gives the same result
+for every pair of pixels. The table is the float rounding of the ratio r = (p1 - p2) / (p1 + p2), so it is non-decreasing in r and the test
+is true exactly for the ratios above some rational q that lies strictly between two consecutive ratios (q = n / d is their mediant). For
+p1 + p2 > 0, r > q is the same as (d - n) * p1 > (d + n) * p2, and since no ratio is equal to q that difference is never zero. The pair (0, 0)
+has an NPD of 0 (the NaN of the table) and gives 0 > 0 on both sides, so c = -1 when q < 0 makes it pass exactly when 0 > threshold.
+*/
+static void convertNpdThresholdToIntegerTest(float threshold, int & a, int & b, int & c) {
+
+  const std::vector < NPD_RATIO > & ratios = getNpdRatios();
+
+  /*First ratio whose NPD is above the threshold*/
+  int low = 0, high = ratios.size();
+  while (low < high) {
+    int middle = (low + high) / 2;
+    if (NPD_VALUES_FOR_EVALUATION[ratios[middle].p1][ratios[middle].p2] > threshold) high = middle;
+    else low = middle + 1;
+  }
+
+  int n, d;
+  if (low == 0) { // Every ratio passes, q = -2 is below all of them
+    n = -2;
+    d = 1;
+  } else if (low == ratios.size()) { // No ratio passes, q = 2 is above all of them
+    n = 2;
+    d = 1;
+  } else {
+    n = ratios[low - 1].n + ratios[low].n;
+    d = ratios[low - 1].d + ratios[low].d;
+  }
+
+  a = d - n;
+  b = d + n;
+  c = (n < 0) ? -1 : 0;
+
+}
+
+/*
+Returns the two pixels (indices inside a training window of p pixels) compared by the NPD feature numFeature. The features are numbered
+as (0, 1), (0, 2) ... (0, p - 1), (1, 2) ... so the first feature of the pixel i is i * (2p - i - 1) / 2, i is found by solving that
+quadratic and correcting the rounding of the square root.
+*/
+static cv::Point2i decodeNpdFeature(int numFeature, int p) {
+
+  double q = 2 * p - 1;
+  int i = (int)((q - std::sqrt(q * q - 8.0 * numFeature)) / 2);
+  while (i > 0 && i * (2 * p - i - 1) / 2 > numFeature) i--;
+  while ((i + 1) * (2 * p - i - 2) / 2 <= numFeature) i++;
+
+  return cv::Point2i(i, numFeature - i * (2 * p - i - 1) / 2 + i + 1);
+}
+
+/*Rotates the pixel (index inside the widthImages x highImages training window) around the center of the window and returns its row and column*/
+static void rotateFeaturePixel(int pixel, double degree, int widthImages, int highImages, int & row, int & col) {
+
+  int x1 = pixel % widthImages;
+  int y1 = pixel / widthImages;
+
+  /*____________ROTATION MATRIX__________________*/
+  cv::Mat MR(2, 2, cv::DataType < double > ::type);
+  MR.at < double > (0, 0) = std::cos(degree * (M_PI / 180));
+  MR.at < double > (0, 1) = std::sin(degree * (M_PI / 180));
+  MR.at < double > (1, 0) = -std::sin(degree * (M_PI / 180));
+  MR.at < double > (1, 1) = std::cos(degree * (M_PI / 180));
+  /*________________________________________________*/
+
+  cv::Mat V1(2, 1, cv::DataType < double > ::type);
+  V1.at < double > (0, 0) = (x1 - (widthImages / 2));
+  V1.at < double > (1, 0) = ((highImages / 2) - y1);
+
+  V1 = MR.t() * V1;
+  /*____________0.5 is for numerical error________________*/
+  col = (int)(V1.at < double > (0, 0) + (widthImages / 2) + 0.5);
+  row = (int)((highImages / 2) - V1.at < double > (1, 0) + 0.5);
+  /*____________________________________________________________*/
+
+}
+
 //____________________________________________________________________________________________________//
 
 class WINDOWING {
@@ -83,19 +226,6 @@ NODE_EVALUATION::~NODE_EVALUATION() {
 
   if (!nodeIsTerminal) {
 
-    //______________Stack where rotated and scaled features are stored_______________//
-    if (!stackFeatures.empty()) {
-      for (int i = 0; i < stackFeatures.size(); i++) {
-
-        for (int j = 0; j < stackFeatures[i].size(); j++) {
-          delete[] stackFeatures[i][j];
-        }
-
-      }
-      stackFeatures.clear();
-    }
-    //____________________________________________________________________________________________//
-
     delete feature;
     delete nodeLeft;
     delete nodeRight;
@@ -117,7 +247,7 @@ void NODE_EVALUATION::loadNode(cv::FileNode nodeRootFile) {
 
   if (!nodeIsTerminal) {
     feature = new cv::Point2i;
-    * feature = parentClassifier -> NPD[numFeature];
+    * feature = decodeNpdFeature(numFeature, parentClassifier -> widthImages * parentClassifier -> highImages);
   }
 
   if (nodeIsTerminal) setNodeAsTerminal(); /*This must be called if the node is terminal*/
@@ -140,86 +270,31 @@ void NODE_EVALUATION::loadNode(cv::FileNode nodeRootFile) {
 
 }
 
-void NODE_EVALUATION::initializeFeatures() {
+void NODE_EVALUATION::initializeFeatures(int & nextNode) {
 
   if (!nodeIsTerminal) {
 
-    //______________Clear the stack, this is in case the established parameters need to be changed_______________//
-    if (!stackFeatures.empty()) {
-      for (int i = 0; i < stackFeatures.size(); i++) {
-
-        for (int j = 0; j < stackFeatures[i].size(); j++) {
-          delete[] stackFeatures[i][j];
-        }
-
-      }
-      stackFeatures.clear();
-    }
-    stackFeatures.reserve(parentClassifier -> degrees.size()); // Introduced on October 5, 2015
-    //________________________________________________________________________________________________________________//
-
-    int x1 = feature -> x % parentClassifier -> widthImages;
-    int y1 = feature -> x / parentClassifier -> widthImages;
-
-    int x2 = feature -> y % parentClassifier -> widthImages;
-    int y2 = feature -> y / parentClassifier -> widthImages;
-
-    for (int i = 0; i < parentClassifier -> degrees.size(); i++) {
-
-      /*____________ROTATION MATRIX__________________*/
-      cv::Mat MR(2, 2, cv::DataType < double > ::type);
-      MR.at < double > (0, 0) = std::cos(parentClassifier -> degrees[i] * (M_PI / 180));
-      MR.at < double > (0, 1) = std::sin(parentClassifier -> degrees[i] * (M_PI / 180));
-      MR.at < double > (1, 0) = -std::sin(parentClassifier -> degrees[i] * (M_PI / 180));
-      MR.at < double > (1, 1) = std::cos(parentClassifier -> degrees[i] * (M_PI / 180));
-      /*________________________________________________*/
-
-      cv::Mat V1(2, 1, cv::DataType < double > ::type);
-      V1.at < double > (0, 0) = (x1 - (parentClassifier -> widthImages / 2));
-      V1.at < double > (1, 0) = ((parentClassifier -> highImages / 2) - y1);
-
-      cv::Mat V2(2, 1, cv::DataType < double > ::type);
-      V2.at < double > (0, 0) = (x2 - (parentClassifier -> widthImages / 2));
-      V2.at < double > (1, 0) = ((parentClassifier -> highImages / 2) - y2);
-
-      V1 = MR.t() * V1;
-      V2 = MR.t() * V2;
-      /*____________0.5 is for numerical error________________*/
-      V1.at < double > (0, 0) = (int)(V1.at < double > (0, 0) + (parentClassifier -> widthImages / 2) + 0.5);
-      V1.at < double > (1, 0) = (int)((parentClassifier -> highImages / 2) - V1.at < double > (1, 0) + 0.5);
-      V2.at < double > (0, 0) = (int)(V2.at < double > (0, 0) + (parentClassifier -> widthImages / 2) + 0.5);
-      V2.at < double > (1, 0) = (int)((parentClassifier -> highImages / 2) - V2.at < double > (1, 0) + 0.5);
-      /*____________________________________________________________*/
-
-      std::vector < int * > stackTemp;
-      //___________________Introduced on October 5, 2015____________________________//
-      int count = 0;
-      for (int sizeBase = parentClassifier -> sizeBaseEvaluation; sizeBase <= parentClassifier -> sizeMaxWindow; sizeBase = (parentClassifier -> factorScaleWindow) * sizeBase) {
-        count++;
-      }
-      //____________________________________________________________________________________//
-      stackTemp.reserve(count);
-
-      for (int sizeBase = parentClassifier -> sizeBaseEvaluation; sizeBase <= parentClassifier -> sizeMaxWindow; sizeBase = (parentClassifier -> factorScaleWindow) * sizeBase) {
+    numberNode = nextNode++;
 
-        int ky = (sizeBase / parentClassifier -> highImages), kx = (sizeBase / parentClassifier -> widthImages);
+    const std::vector < double > & degrees = parentClassifier -> degrees;
+    int numberNodes = parentClassifier -> numberGraphNodes;
+    int row1, col1, row2, col2;
 
-        int * vecTemp = new int[4];
-        vecTemp[0] = ky * V1.at < double > (1, 0);
-        vecTemp[1] = kx * V1.at < double > (0, 0);
-        vecTemp[2] = ky * V2.at < double > (1, 0);
-        vecTemp[3] = kx * V2.at < double > (0, 0);
+    for (int i = 0; i < degrees.size(); i++) {
 
-        stackTemp.push_back(vecTemp);
+      rotateFeaturePixel(feature -> x, degrees[i], parentClassifier -> widthImages, parentClassifier -> highImages, row1, col1);
+      rotateFeaturePixel(feature -> y, degrees[i], parentClassifier -> widthImages, parentClassifier -> highImages, row2, col2);
 
-      }
-
-      stackFeatures.push_back(stackTemp);
+      short * vecTemp = & parentClassifier -> graphFeatures[4 * (i * numberNodes + numberNode)];
+      vecTemp[0] = row1;
+      vecTemp[1] = col1;
+      vecTemp[2] = row2;
+      vecTemp[3] = col2;
 
     }
 
-    nodeLeft -> initializeFeatures();
-    nodeRight -> initializeFeatures();
+    nodeLeft -> initializeFeatures(nextNode);
+    nodeRight -> initializeFeatures(nextNode);
   }
 
 }
@@ -230,10 +305,12 @@ double NODE_EVALUATION::evaluateNode(cv::Mat & image, int scale, int orderDegree
 
 double NODE_EVALUATION::evaluateNodeNoTerminal(cv::Mat & image, int scale, int orderDegrees) {
 
-  int * vecTemp = (stackFeatures[orderDegrees])[scale];
+  const short * vecTemp = & parentClassifier -> graphFeatures[4 * (orderDegrees * parentClassifier -> numberGraphNodes + numberNode)];
+  int sizeBase = parentClassifier -> scaleSizes[scale];
+  int ky = (sizeBase / parentClassifier -> highImages), kx = (sizeBase / parentClassifier -> widthImages);
 
-  int p1 = image.at < uchar > (vecTemp[0], vecTemp[1]);
-  int p2 = image.at < uchar > (vecTemp[2], vecTemp[3]);
+  int p1 = image.at < uchar > (ky * vecTemp[0], kx * vecTemp[1]);
+  int p2 = image.at < uchar > (ky * vecTemp[2], kx * vecTemp[3]);
 
   /*
   int delta=1;
@@ -256,8 +333,8 @@ TREE_TRAINING_EVALUATION::~TREE_TRAINING_EVALUATION() {
   delete nodeRoot; // The root node is deleted, which will call the destructors of its child nodes in sequence
 }
 
-void TREE_TRAINING_EVALUATION::initializeFeatures() {
-  nodeRoot -> initializeFeatures();
+void TREE_TRAINING_EVALUATION::initializeFeatures(int & nextNode) {
+  nodeRoot -> initializeFeatures(nextNode);
 }
 
 void TREE_TRAINING_EVALUATION::loadWeakLearn(cv::FileNode weakLearnsTrees, int num) {
@@ -289,10 +366,10 @@ STRONG_LEARN_EVALUATION::~STRONG_LEARN_EVALUATION() {
 
 }
 
-void STRONG_LEARN_EVALUATION::initializeFeatures() {
+void STRONG_LEARN_EVALUATION::initializeFeatures(int & nextNode) {
 
   for (int i = 0; i < weakLearns.size(); i++)
-    weakLearns[i] -> initializeFeatures();
+    weakLearns[i] -> initializeFeatures(nextNode);
 
 }
 
@@ -317,7 +394,6 @@ void STRONG_LEARN_EVALUATION::loadStrongLearn(cv::FileNode fileStrongLearn, int
     weakLearns.push_back(treeAux);
   }
 
-  std::cout << "Strong classifier number=" << stage << "\n"; // Debug message showing the current strong classifier number
 }
 
 double STRONG_LEARN_EVALUATION::evaluateStrongLearnWithZeroThreshold(cv::Mat & image, int scale, int orderDegrees) {
@@ -354,449 +430,2622 @@ bool STRONG_LEARN_EVALUATION::FDDB_evaluateStrongLearn(cv::Mat & image, int scal
 
 #endif
 
-CASCADE_CLASSIFIERS_EVALUATION::CASCADE_CLASSIFIERS_EVALUATION(std::string nameFile): NPD(NULL) {
+void FLAT_CASCADE_EVALUATION::clear() {
 
-  fileCascadeClassifier = new cv::FileStorage(nameFile, cv::FileStorage::READ);
-  loadCascadeClasifier();
+  stageTreeBegin.clear();
+  stageThreshold.clear();
+  treeRoot.clear();
+  nodeChildren.clear();
+  nodeThreshold.clear();
+  nodeSplitTest.clear();
+  nodeFeature.clear();
+  leafValue.clear();
+  generatedStages = NULL;
+  treeRejection.clear();
+  flagRejectionTraces = false;
 
-  //______________THIS SHOULD BE DONE AFTER LOADING THE FULL CLASSIFIER_____________________
-  degrees.push_back(0); // Zero degrees
-  factorScaleWindow = 1.2; // 1.2 was the value that worked best in tests
-  stepWindow = 0.2; // 0.2 was the value that worked best in tests
-  sizeMaxWindow = 640; // Generally, images won't exceed this size; for larger sizes, modify it
-  initializeFeatures(); // Features are initialized with the previous parameters
-  //_______________________________________________________________________________________________
+}
 
-  //______Other default parameters__________//
-  lineThicknessRectangles = 1;
-  colorRectangles = cv::Scalar(0, 255, 0); // Default color is green
-  groupThreshold = 1;
-  eps = 0.2;
-  flagActivateSkinColor = false; // By default, skin color is not activated
-  hsvMin = cv::Scalar(0, 10, 60); // Minimum value, works very well
-  hsvMax = cv::Scalar(20, 150, 255); // Maximum value, works very well
-  flagExtractColorImages = false; // By default, detected regions are returned in grayscale
+void FLAT_CASCADE_EVALUATION::compileTree(const NODE_EVALUATION * nodeRoot) {
 
-  numberClassifiersUsed = strongLearnsEvaluation.size();
+  if (nodeRoot -> nodeIsTerminal) { // A tree made of a single leaf
+    treeRoot.push_back(~(int) leafValue.size());
+    leafValue.push_back(nodeRoot -> yt);
+    return;
+  }
 
-  //____________________________________________//
+  /*The split nodes are numbered in breadth-first order, so queue[k] will be stored at firstNode + k*/
+  int firstNode = nodeThreshold.size();
+  std::vector < const NODE_EVALUATION * > queue;
+  queue.push_back(nodeRoot);
+
+  for (int k = 0; k < queue.size(); k++) {
+
+    const NODE_EVALUATION * node = queue[k];
+    const NODE_EVALUATION * children[2] = {
+      node -> nodeLeft,
+      node -> nodeRight
+    };
+
+    int childrenIndex[2];
+    for (int c = 0; c < 2; c++) {
+      if (children[c] -> nodeIsTerminal) {
+        childrenIndex[c] = ~(int) leafValue.size();
+        leafValue.push_back(children[c] -> yt);
+      } else {
+        childrenIndex[c] = firstNode + queue.size();
+        queue.push_back(children[c]);
+      }
+    }
 
-}
+    /*The float NPD table is compared with a double threshold, rounding the threshold toward -infinity keeps exactly the same comparison*/
+    float thresholdNode = (float) node -> threshold;
+    if ((double) thresholdNode > node -> threshold) thresholdNode = nextafterf(thresholdNode, -FLT_MAX);
 
-CASCADE_CLASSIFIERS_EVALUATION::~CASCADE_CLASSIFIERS_EVALUATION() {
+    nodeThreshold.push_back(thresholdNode);
+
+    int a, b, c;
+    convertNpdThresholdToIntegerTest(thresholdNode, a, b, c);
+    nodeSplitTest.push_back(a);
+    nodeSplitTest.push_back(b);
+    nodeSplitTest.push_back(c);
+
+    nodeFeature.push_back( * node -> feature);
+    nodeChildren.push_back(childrenIndex[0]);
+    nodeChildren.push_back(childrenIndex[1]);
 
-  // We delete the dynamic memory for the vector that stores the NPD
-  if (NPD != NULL) {
-    delete[] NPD;
-    NPD = NULL;
   }
 
-  // We delete the dynamic memory for the strongLearns
-  for (int i = 0; i < strongLearnsEvaluation.size(); i++)
-    delete strongLearnsEvaluation[i];
-  strongLearnsEvaluation.clear();
+  treeRoot.push_back(firstNode);
 
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::initializeFeatures() {
+void FLAT_CASCADE_EVALUATION::compileStrongLearn(const STRONG_LEARN_EVALUATION * strongLearn) {
 
-  for (int i = 0; i < strongLearnsEvaluation.size(); i++)
-    strongLearnsEvaluation[i] -> initializeFeatures();
+  if (stageTreeBegin.empty()) stageTreeBegin.push_back(0);
 
-  zsBackground = 0.8 * double(sizeMaxWindow);
-  szImg = cv::Size(0, 0);
+  for (int i = 0; i < strongLearn -> weakLearns.size(); i++)
+    compileTree(strongLearn -> weakLearns[i] -> nodeRoot);
 
-}
+  stageThreshold.push_back(strongLearn -> threshold);
+  stageTreeBegin.push_back(treeRoot.size());
 
-void CASCADE_CLASSIFIERS_EVALUATION::setDegreesDetections(std::vector < double > myDegrees) {
-  degrees = myDegrees;
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::setSizeBase(int sizeBase) {
-  sizeBaseEvaluation = sizeBase;
-}
+void FLAT_CASCADE_EVALUATION::computeOffsets(const std::vector < double > & degrees, const std::vector < int > & kx, const std::vector < int > & ky, int widthImages, int highImages, int stride, std::vector < int > & offsetsTable) const {
 
-void CASCADE_CLASSIFIERS_EVALUATION::setFactorScaleWindow(double factorScale) {
-  factorScaleWindow = factorScale;
-}
+  int numberNodes = getNumberSplitNodes();
+  int scales = kx.size();
 
-void CASCADE_CLASSIFIERS_EVALUATION::setStepWindow(double factorStep) {
-  stepWindow = factorStep;
-}
+  offsetsTable.assign(2 * numberNodes * scales * degrees.size(), 0);
 
-void CASCADE_CLASSIFIERS_EVALUATION::setSizeMaxWindow(double maxSize) {
-  sizeMaxWindow = maxSize;
-}
+  int row1, col1, row2, col2;
+  for (int d = 0; d < degrees.size(); d++) {
+    for (int n = 0; n < numberNodes; n++) {
 
-void CASCADE_CLASSIFIERS_EVALUATION::setLineThicknessRectangles(int thicknessRectangles) {
+      rotateFeaturePixel(nodeFeature[n].x, degrees[d], widthImages, highImages, row1, col1);
+      rotateFeaturePixel(nodeFeature[n].y, degrees[d], widthImages, highImages, row2, col2);
 
-  lineThicknessRectangles = thicknessRectangles;
+      for (int s = 0; s < scales; s++) {
+        int * offsets = & offsetsTable[2 * ((d * scales + s) * numberNodes + n)];
+        offsets[0] = ky[s] * row1 * stride + kx[s] * col1;
+        offsets[1] = ky[s] * row2 * stride + kx[s] * col2;
+      }
+
+    }
+  }
 
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::setColorRectangles(const cv::Scalar & color) {
+void FLAT_CASCADE_EVALUATION::computeCoordinates(const std::vector < double > & degrees, int widthImages, int highImages, std::vector < short > & coordinatesTable, cv::Rect & footprint) const {
 
-  colorRectangles = color;
+  int numberNodes = getNumberSplitNodes();
+  coordinatesTable.assign(4 * numberNodes * degrees.size(), 0);
 
-}
+  /*The footprint always contains the window, so a window inside the image is never evaluated with clamping only because of its size*/
+  int minRow = 0, minCol = 0, maxRow = highImages - 1, maxCol = widthImages - 1;
 
-void CASCADE_CLASSIFIERS_EVALUATION::setGroupThreshold(int threshold) {
-  groupThreshold = threshold;
-}
+  for (int d = 0; d < degrees.size(); d++) {
+    for (int n = 0; n < numberNodes; n++) {
 
-void CASCADE_CLASSIFIERS_EVALUATION::setEps(double myEps) {
-  eps = myEps;
-}
+      short * coordinates = & coordinatesTable[4 * (d * numberNodes + n)];
+      int row1, col1, row2, col2;
+      rotateFeaturePixel(nodeFeature[n].x, degrees[d], widthImages, highImages, row1, col1);
+      rotateFeaturePixel(nodeFeature[n].y, degrees[d], widthImages, highImages, row2, col2);
+      coordinates[0] = row1;
+      coordinates[1] = col1;
+      coordinates[2] = row2;
+      coordinates[3] = col2;
 
-void CASCADE_CLASSIFIERS_EVALUATION::setFlagActivateSkinColor(bool activateSkinColor) {
-  flagActivateSkinColor = activateSkinColor;
-}
+      minRow = std::min(minRow, std::min(row1, row2));
+      maxRow = std::max(maxRow, std::max(row1, row2));
+      minCol = std::min(minCol, std::min(col1, col2));
+      maxCol = std::max(maxCol, std::max(col1, col2));
+
+    }
+  }
+
+  footprint = cv::Rect(minCol, minRow, maxCol - minCol + 1, maxRow - minRow + 1);
 
-void CASCADE_CLASSIFIERS_EVALUATION::setFlagExtractColorImages(bool extractColorImages) {
-  flagExtractColorImages = extractColorImages;
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::setNumberClassifiersUsed(int number) {
+void FLAT_CASCADE_EVALUATION::computePyramidOffsets(const std::vector < double > & degrees, int widthImages, int highImages, int stride, std::vector < int > & offsetsTable) const {
 
-  if (number < 1)
-    numberClassifiersUsed = 1;
-  else if (number > strongLearnsEvaluation.size())
-    numberClassifiersUsed = strongLearnsEvaluation.size();
-  else
-    numberClassifiersUsed = number;
+  std::vector < int > nativeScale(1, 1);
+  computeOffsets(degrees, nativeScale, nativeScale, widthImages, highImages, stride, offsetsTable);
 
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::setHsvMin(const cv::Scalar & hsv) {
-  hsvMin = hsv;
-}
+int FLAT_CASCADE_EVALUATION::validateIntegerSplitTests() const {
 
-void CASCADE_CLASSIFIERS_EVALUATION::setHsvMax(const cv::Scalar & hsv) {
-  hsvMax = hsv;
-}
+  int mismatches = 0;
 
-int CASCADE_CLASSIFIERS_EVALUATION::getNumberStrongLearns() const {
-  return strongLearnsEvaluation.size();
+  for (int n = 0; n < getNumberSplitNodes(); n++) {
+    const int * test = & nodeSplitTest[3 * n];
+    for (int p1 = 0; p1 < pixelResolution; p1++) {
+      for (int p2 = 0; p2 < pixelResolution; p2++) {
+        if ((NPD_VALUES_FOR_EVALUATION[p1][p2] > nodeThreshold[n]) != (test[0] * p1 - test[1] * p2 > test[2])) mismatches++;
+      }
+    }
+  }
+
+  std::cout << "Integer split tests validated on " << getNumberSplitNodes() << " nodes, mismatches=" << mismatches << "\n";
+
+  return mismatches;
 }
 
-double CASCADE_CLASSIFIERS_EVALUATION::getSizeMaxWindow() const {
-  return sizeMaxWindow;
+/*FNV-1a hash of size bytes*/
+static unsigned int hashBytes(unsigned int hash, const void * data, int size) {
+  const unsigned char * bytes = (const unsigned char * ) data;
+  for (int i = 0; i < size; i++) {
+    hash = hash ^ bytes[i];
+    hash = hash * 16777619u;
+  }
+  return hash;
 }
 
-cv::Scalar CASCADE_CLASSIFIERS_EVALUATION::getHsvMin() const {
-  return hsvMin;
+template < typename T > static unsigned int hashVector(unsigned int hash, const std::vector < T > & v) {
+  int size = v.size();
+  hash = hashBytes(hash, & size, sizeof(size));
+  return v.empty() ? hash : hashBytes(hash, & v[0], v.size() * sizeof(T));
 }
 
-cv::Scalar CASCADE_CLASSIFIERS_EVALUATION::getHsvMax() const {
-  return hsvMax;
+unsigned int FLAT_CASCADE_EVALUATION::getFingerprint() const {
+
+  unsigned int hash = 2166136261u;
+  hash = hashVector(hash, stageTreeBegin);
+  hash = hashVector(hash, stageThreshold);
+  hash = hashVector(hash, treeRoot);
+  hash = hashVector(hash, nodeChildren);
+  hash = hashVector(hash, nodeSplitTest);
+  hash = hashVector(hash, nodeFeature);
+  hash = hashVector(hash, leafValue);
+
+  return hash;
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::generateFeatures() {
+void FLAT_CASCADE_EVALUATION::generateNodeCode(std::ostream & out, int node, int indentation) const {
 
-  int p = widthImages * highImages;
-  int numberFeature = p * (p - 1) / 2; // This is the result of summing (p-1)+(p-2)....+1
+  std::string indent(indentation, ' ');
 
-  if (NPD != NULL) {
-    delete[] NPD; /* This will free memory if a double call occurs, because the base width and height might change */
-    NPD = NULL;
+  if (node < 0) {
+    out << indent << "sum = sum + " << leafValue[~node] << ";\n";
+    return;
   }
 
-  NPD = new cv::Point2i[numberFeature]; // Requesting space to store features
-  // ____ Filling with the values of each coordinate ___
-  int count = 0;
-  for (int i = 0; i < p; i++) {
-    for (int j = i + 1; j < p; j++) {
-      NPD[count] = cv::Point2i(i, j); /* For the calculation, apply (xi-xj)/(xi+xj), where xi and xj are the pixels at coordinates i and j respectively. */
-      count++;
-    }
-  }
+  const int * test = & nodeSplitTest[3 * node];
+  out << indent << "if (" << test[0] << " * window[offsets[" << 2 * node << "]] - (" << test[1] << ") * window[offsets[" << 2 * node + 1 << "]] > " << test[2] << ") {\n";
+  generateNodeCode(out, nodeChildren[2 * node + 1], indentation + 2);
+  out << indent << "} else {\n";
+  generateNodeCode(out, nodeChildren[2 * node], indentation + 2);
+  out << indent << "}\n";
 
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::loadCascadeClasifier() {
+void FLAT_CASCADE_EVALUATION::generateCode(std::ostream & out) const {
 
-  /* ____________________ Here begins the classifier reading ________________________ */
+  out.precision(17); // Enough digits to read back exactly the same doubles
 
-  cv::FileNode information = (*fileCascadeClassifier)["information"];
+  out << "/*Generated by tools/generateCascadeCode, do not edit*/\n\n";
+  out << "#include \"generatedCascade.h\"\n\n";
 
-  /*__________ HERE IMPORTANT VARIABLES ARE UPDATED __________*/
+  for (int s = 0; s < getNumberStages(); s++) {
+    out << "static double evaluateStage" << s << "(const unsigned char * window, const int * offsets) {\n";
+    out << "  double sum = 0;\n";
+    for (int t = stageTreeBegin[s]; t < stageTreeBegin[s + 1]; t++)
+      generateNodeCode(out, treeRoot[t], 2);
+    out << "  return sum;\n";
+    out << "}\n\n";
+  }
 
-  widthImages = (int) information["G_WIDTH_IMAGE"];
-  highImages = (int) information["G_HEIGHT_IMAGE"];
-  sizeBaseEvaluation = std::min(widthImages, highImages); // By default, its size is the smaller side of the image size
-  generateFeatures(); // Must be called after widthImages and highImages are assigned
+  out << "const unsigned int GENERATED_CASCADE_FINGERPRINT = " << getFingerprint() << "u;\n";
+  out << "const int GENERATED_CASCADE_NUMBER_STAGES = " << getNumberStages() << ";\n";
+  out << "const GENERATED_STAGE_EVALUATION GENERATED_CASCADE_STAGES[] = {\n";
+  for (int s = 0; s < getNumberStages(); s++)
+    out << "  evaluateStage" << s << (s + 1 < getNumberStages() ? ",\n" : "\n");
+  out << "};\n";
 
-  /*_______________________________________________________________*/
+}
 
-  /* Next, each strong learn is loaded */
-  cv::FileNode cascade_classifiers = (*fileCascadeClassifier)["cascade_classifiers"];
-  strongLearnsEvaluation.reserve(cascade_classifiers.size());
+bool FLAT_CASCADE_EVALUATION::attachGeneratedStages(const GENERATED_STAGE_EVALUATION * stages, int numberStages, unsigned int fingerprint) {
 
-  for (int i = 0; i < cascade_classifiers.size(); i++) {
-    STRONG_LEARN_EVALUATION* strongLearnAux = new STRONG_LEARN_EVALUATION(this);
-    strongLearnAux->loadStrongLearn(cascade_classifiers, i); /* Here each classifier is loaded */
-    strongLearnsEvaluation.push_back(strongLearnAux);
+  if (numberStages != getNumberStages() || fingerprint != getFingerprint()) {
+    generatedStages = NULL;
+    return false;
   }
 
-  fileCascadeClassifier->release();
-  if (fileCascadeClassifier != NULL) delete fileCascadeClassifier;
-
+  generatedStages = stages;
+  return true;
 }
 
-bool CASCADE_CLASSIFIERS_EVALUATION::evaluateClassifier(cv::Mat& image, int scale, int orderDegrees) {
+/*
+Binary cascade files start with the following header, after it the arrays of FLAT_CASCADE_EVALUATION are stored one after another in the
+order of writeBinary. The version must change whenever that layout changes.
+*/
+static
+const char binaryCascadeMagic[8] = {'U', 'V', 'F', 'C', 'A', 'S', 'C', '\0'};
+static
+const int binaryCascadeVersion = 1;
+static
+const int binaryCascadeByteOrder = 0x01020304; //Written as it is in memory, so a file from a machine with another byte order is detected
+
+class BINARY_CASCADE_HEADER {
+  public: char magic[8];
+  int version;
+  int byteOrder;
+  int widthImages;
+  int highImages;
+  int numberStages;
+  int numberTrees;
+  int numberSplitNodes;
+  int numberLeaves;
+};
 
-  for (int i = 0; i < numberClassifiersUsed; i++)
-    if (!strongLearnsEvaluation[i]->evaluateStrongLearn(image, scale, orderDegrees)) return false; /* Classified as negative label */
+template < typename T > static void writeVector(std::ostream & out, const std::vector < T > & v) {
+  if (!v.empty()) out.write((const char * ) & v[0], v.size() * sizeof(T));
+}
 
-  return true; /* Classified as positive label */
+/*Copies size elements from data into v, returns false if there are not enough bytes left*/
+template < typename T > static bool readVector(const char * & data, const char * end, int size, std::vector < T > & v) {
+  if (size < 0 || (end - data) / (long) sizeof(T) < size) return false;
+  v.resize(size);
+  if (size > 0) std::memcpy( & v[0], data, size * sizeof(T));
+  data = data + size * sizeof(T);
+  return true;
+}
+
+void FLAT_CASCADE_EVALUATION::writeBinary(std::ostream & out, int widthImages, int highImages) const {
+
+  BINARY_CASCADE_HEADER header;
+  std::memcpy(header.magic, binaryCascadeMagic, sizeof(header.magic));
+  header.version = binaryCascadeVersion;
+  header.byteOrder = binaryCascadeByteOrder;
+  header.widthImages = widthImages;
+  header.highImages = highImages;
+  header.numberStages = getNumberStages();
+  header.numberTrees = treeRoot.size();
+  header.numberSplitNodes = getNumberSplitNodes();
+  header.numberLeaves = leafValue.size();
+
+  out.write((const char * ) & header, sizeof(header));
+  writeVector(out, stageTreeBegin);
+  writeVector(out, stageThreshold);
+  writeVector(out, treeRoot);
+  writeVector(out, nodeChildren);
+  writeVector(out, nodeThreshold);
+  writeVector(out, nodeSplitTest);
+  writeVector(out, nodeFeature);
+  writeVector(out, leafValue);
 
 }
 
-bool CASCADE_CLASSIFIERS_EVALUATION::evaluateClassifier(cv::Mat& image, int scale, int orderDegrees, int begin, int end) {
+bool FLAT_CASCADE_EVALUATION::readBinary(const char * data, long size, int & widthImages, int & highImages) {
 
-  for (int i = begin; i < end; i++)
-    if (!strongLearnsEvaluation[i]->evaluateStrongLearn(image, scale, orderDegrees)) return false; /* Classified as negative label */
+  clear();
 
-  scoreDetection = strongLearnsEvaluation[end - 1]->scoreDetection;
+  BINARY_CASCADE_HEADER header;
+  if (size < (long) sizeof(header)) return false;
+  std::memcpy( & header, data, sizeof(header));
 
-  return true; /* Classified as positive label */
+  if (std::memcmp(header.magic, binaryCascadeMagic, sizeof(header.magic)) != 0) return false;
+  if (header.version != binaryCascadeVersion) {
+    std::cout << "Binary cascade version " << header.version << " is not supported (expected " << binaryCascadeVersion << ")\n";
+    return false;
+  }
+  if (header.byteOrder != binaryCascadeByteOrder) {
+    std::cout << "The binary cascade was written on a machine with another byte order\n";
+    return false;
+  }
 
+  const char * end = data + size;
+  data = data + sizeof(header);
+
+  bool ok = readVector(data, end, header.numberStages + 1, stageTreeBegin) &&
+    readVector(data, end, header.numberStages, stageThreshold) &&
+    readVector(data, end, header.numberTrees, treeRoot) &&
+    readVector(data, end, 2 * header.numberSplitNodes, nodeChildren) &&
+    readVector(data, end, header.numberSplitNodes, nodeThreshold) &&
+    readVector(data, end, 3 * header.numberSplitNodes, nodeSplitTest) &&
+    readVector(data, end, header.numberSplitNodes, nodeFeature) &&
+    readVector(data, end, header.numberLeaves, leafValue) &&
+    data == end &&
+    header.widthImages > 0 && header.highImages > 0 &&
+    hasValidIndices(header.widthImages, header.highImages);
+
+  if (!ok) {
+    std::cout << "The binary cascade is truncated or corrupt\n";
+    clear();
+    return false;
+  }
+
+  widthImages = header.widthImages;
+  highImages = header.highImages;
+
+  return true;
 }
 
-// __________________________________ DECLARING DIFFERENT DETECTION FUNCTIONS __________________________________
+bool FLAT_CASCADE_EVALUATION::hasValidIndices(int widthImages, int highImages) const {
+
+  int numberTrees = treeRoot.size(), numberNodes = getNumberSplitNodes(), numberLeaves = leafValue.size();
 
-void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesUngrouped(cv::Mat& image) {
+  /*The trees of the stages follow one another and are all the trees*/
+  if (stageTreeBegin.empty() || stageTreeBegin[0] != 0 || stageTreeBegin.back() != numberTrees) return false;
+  for (int s = 0; s + 1 < stageTreeBegin.size(); s++)
+    if (stageTreeBegin[s] > stageTreeBegin[s + 1]) return false;
 
-  if (szImg != image.size()) {
-    ImageBackground = cv::Mat::zeros(sizeMaxWindow + 2 * zsBackground, sizeMaxWindow + 2 * zsBackground, CV_8UC1);
-    imageGray = ImageBackground(cv::Range(zsBackground, zsBackground + image.rows), cv::Range(zsBackground, zsBackground + image.cols));
-    szImg = image.size();
+  /*A child is a leaf or a split node stored after its parent (breadth-first, see compileTree), so the evaluation of a tree always ends*/
+  for (int t = 0; t < numberTrees; t++) {
+    int root = treeRoot[t];
+    if (root >= numberNodes || (root < 0 && ~root >= numberLeaves)) return false;
   }
+  for (int n = 0; n < numberNodes; n++)
+    for (int c = 0; c < 2; c++) {
+      int child = nodeChildren[2 * n + c];
+      if ((child >= 0 && (child <= n || child >= numberNodes)) || (child < 0 && ~child >= numberLeaves)) return false;
+    }
 
-  cvtColor(image, imageGray, CV_BGR2GRAY); // Converting to grayscale
+  /*The two pixels of each split node are in the training window*/
+  int pixels = widthImages * highImages;
+  for (int n = 0; n < numberNodes; n++)
+    if (nodeFeature[n].x < 0 || nodeFeature[n].x >= pixels || nodeFeature[n].y < 0 || nodeFeature[n].y >= pixels) return false;
 
-  if (flagActivateSkinColor) {
-    cvtColor(image, hsv, CV_BGR2HSV);
-    inRange(hsv, hsvMin, hsvMax, bw);
-    integral(bw, integralBw, CV_32S);
-  }
+  return true;
+}
 
-  int idx = 0;
+int FLAT_CASCADE_EVALUATION::getNumberStages() const {
+  return stageThreshold.size();
+}
 
-  if (flagActivateSkinColor) {
-    //______________________________________________________________________________________________________________________//
-    for (int sizeBase = sizeBaseEvaluation; sizeBase <= std::min(image.rows, image.cols); sizeBase = factorScaleWindow * sizeBase, idx++) {
-      int step_x = sizeBase * stepWindow; /* In this factor, the search window will move in rows */
-      int step_y = sizeBase * stepWindow; /* In this factor, the search window will move in columns */
-      for (int i = 0; i <= image.rows - sizeBase; i = i + step_x) {
-        for (int j = 0; j <= image.cols - sizeBase; j = j + step_y) {
+double FLAT_CASCADE_EVALUATION::getStageThreshold(int stage) const {
+  return stageThreshold[stage];
+}
 
-          /*__________ CALCULATING WINDOW POSITION __________*/
-          int topLeft_x = i;
-          int topLeft_y = j;
-          int bottomRight_x = sizeBase + i - 1;
-          int bottomRight_y = sizeBase + j - 1;
-          /*____________________________________________________________*/
+int FLAT_CASCADE_EVALUATION::getNumberSplitNodes() const {
+  return nodeThreshold.size();
+}
 
-          cv::Mat window;
-          window = imageGray(cv::Range(topLeft_x, bottomRight_x + 1), cv::Range(topLeft_y, bottomRight_y + 1));
+template < typename T > static size_t bytesOf(const std::vector < T > & v) {
+  return v.capacity() * sizeof(T);
+}
 
-          bool flagDetected = false;
-          double myDegree = 0;
-          int num = 0;
+size_t FLAT_CASCADE_EVALUATION::getModelBytes() const {
+  return bytesOf(stageTreeBegin) + bytesOf(stageThreshold) + bytesOf(treeRoot) + bytesOf(nodeChildren) + bytesOf(nodeThreshold) + bytesOf(nodeSplitTest) + bytesOf(nodeFeature) + bytesOf(leafValue) + bytesOf(treeRejection);
+}
 
-          double sum2 = integralBw.at<int>(bottomRight_x + 1, bottomRight_y + 1) + integralBw.at<int>(topLeft_x, topLeft_y) - (integralBw.at<int>(bottomRight_x + 1, topLeft_y) + integralBw.at<int>(topLeft_x, bottomRight_y + 1)); // Integral image evaluation
 
-          if (sum2 > 76.5 * sizeBase * sizeBase) { // 76.5 = 255*0.3
+inline double FLAT_CASCADE_EVALUATION::evaluateStage(const uchar * window, const int * offsets, int stage) const {
 
-            for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
-              if (evaluateClassifier(window, idx, orderDegrees)) {
+  const double * rejection = flagRejectionTraces ? & treeRejection[0] : NULL;
 
-                myDegree = myDegree + degrees[orderDegrees];
-                flagDetected = true;
-                num++;
+  if (generatedStages != NULL && rejection == NULL) return generatedStages[stage](window, offsets);
 
-              }
-            }
+  const int * children = & nodeChildren[0];
+  const int * tests = & nodeSplitTest[0];
+  const double * leaves = & leafValue[0];
 
-          }
+  double evaluation = 0;
 
-          if (flagDetected == true) {
+  for (int t = stageTreeBegin[stage]; t < stageTreeBegin[stage + 1]; t++) {
 
-            myDegree = myDegree / num;
-            cv::RotatedRect rectRotate(cv::Point2f(j + (sizeBase / 2), i + (sizeBase / 2)), cv::Size2f(sizeBase, sizeBase), -myDegree);
-            cv::Point2f vertices[4];
-            rectRotate.points(vertices);
-            for (int i = 0; i < 4; i++)
-              cv::line(image, vertices[i], vertices[(i + 1) % 4], colorRectangles, lineThicknessRectangles);
+    int node = treeRoot[t];
+    while (node >= 0) {
+      int p1 = window[offsets[2 * node]];
+      int p2 = window[offsets[2 * node + 1]];
+      const int * test = tests + 3 * node;
+      node = children[2 * node + (test[0] * p1 - test[1] * p2 > test[2])]; /*Right child if the NPD is above the threshold*/
+    }
+    evaluation = evaluation + leaves[~node];
 
-          }
+    if (rejection != NULL && evaluation < rejection[t]) return -HUGE_VAL; /*Rejected by the trace, no window with this partial sum passed the calibration*/
 
-        }
-      }
+  }
 
-    }
-    //_______________________________________________________________________________________________________________________//
-  } else {
-    //_______________________________________________________________________________________________________________________//
-    for (int sizeBase = sizeBaseEvaluation; sizeBase <= std::min(image.rows, image.cols); sizeBase = factorScaleWindow * sizeBase, idx++) {
-      int step_x = sizeBase * stepWindow; /* In this factor, the search window will move in rows */
-      int step_y = sizeBase * stepWindow; /* In this factor, the search window will move in columns */
-      for (int i = 0; i <= image.rows - sizeBase; i = i + step_x) {
-        for (int j = 0; j <= image.cols - sizeBase; j = j + step_y) {
-
-          /*__________ CALCULATING WINDOW POSITION __________*/
-          int topLeft_x = i;
-          int topLeft_y = j;
-          int bottomRight_x = sizeBase + i - 1;
-          int bottomRight_y = sizeBase + j - 1;
-          /*____________________________________________________________*/
-
-          cv::Mat window;
-          window = imageGray(cv::Range(topLeft_x, bottomRight_x + 1), cv::Range(topLeft_y, bottomRight_y + 1));
-
-          bool flagDetected = false;
-          double myDegree = 0;
-          int num = 0;
-
-          for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
-            if (evaluateClassifier(window, idx, orderDegrees)) {
-
-              myDegree = myDegree + degrees[orderDegrees];
-              flagDetected = true;
-              num++;
+  return evaluation;
+}
 
-            }
-          }
+bool FLAT_CASCADE_EVALUATION::traceWindow(const uchar * window, const int * offsets, double * partialSums) const {
 
-          if (flagDetected == true) {
+  const int * children = & nodeChildren[0];
+  const int * tests = & nodeSplitTest[0];
+  const double * leaves = & leafValue[0];
 
-            myDegree = myDegree / num;
-            cv::RotatedRect rectRotate(cv::Point2f(j + (sizeBase / 2), i + (sizeBase / 2)), cv::Size2f(sizeBase, sizeBase), -myDegree);
-            cv::Point2f vertices[4];
-            rectRotate.points(vertices);
-            for (int i = 0; i < 4; i++)
-              cv::line(image, vertices[i], vertices[(i + 1) % 4], colorRectangles, lineThicknessRectangles);
+  for (int s = 0; s < getNumberStages(); s++) {
 
-          }
+    double evaluation = 0;
 
-        }
+    for (int t = stageTreeBegin[s]; t < stageTreeBegin[s + 1]; t++) {
+      int node = treeRoot[t];
+      while (node >= 0) {
+        int p1 = window[offsets[2 * node]];
+        int p2 = window[offsets[2 * node + 1]];
+        const int * test = tests + 3 * node;
+        node = children[2 * node + (test[0] * p1 - test[1] * p2 > test[2])];
       }
-
+      evaluation = evaluation + leaves[~node];
+      partialSums[t] = evaluation;
     }
-    //___________________________________________________________________________________________________//
+
+    if (evaluation < stageThreshold[s]) return false;
+
   }
 
+  return true;
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesGroupedZeroDegrees(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects, std::vector < cv::Rect > * coordinatesDetectedObjects, bool doubleDetectedList, bool paintDetections) {
+int FLAT_CASCADE_EVALUATION::getNumberTrees() const {
+  return treeRoot.size();
+}
 
-  if (szImg != image.size()) {
-    ImageBackground = cv::Mat::zeros(sizeMaxWindow + 2 * zsBackground, sizeMaxWindow + 2 * zsBackground, CV_8UC1);
-    imageGray = ImageBackground(cv::Range(zsBackground, zsBackground + image.rows), cv::Range(zsBackground, zsBackground + image.cols));
-    szImg = image.size();
-  }
+int FLAT_CASCADE_EVALUATION::getNumberTrees(int beginStage, int endStage) const {
+  return stageTreeBegin[endStage] - stageTreeBegin[beginStage];
+}
 
-  cvtColor(image, imageGray, CV_BGR2GRAY); // Converting to grayscale
+bool FLAT_CASCADE_EVALUATION::setRejectionTraces(const std::vector < double > & traces) {
 
-  if (flagActivateSkinColor) {
-    cvtColor(image, hsv, CV_BGR2HSV);
-    inRange(hsv, hsvMin, hsvMax, bw);
-    integral(bw, integralBw, CV_32S);
-  }
+  if (traces.size() != getNumberTrees()) return false;
 
-  int idx = 0;
+  treeRejection = traces;
+  return true;
+}
 
-  if (flagActivateSkinColor) {
-    //_______________________________________________________________________________________________________________________//
-    for (int sizeBase = sizeBaseEvaluation; sizeBase <= std::min(image.rows, image.cols); sizeBase = factorScaleWindow * sizeBase, idx++) {
-      int step_x = sizeBase * stepWindow; /* In this factor, the search window will move in rows */
-      int step_y = sizeBase * stepWindow; /* In this factor, the search window will move in columns */
-      for (int i = 0; i <= image.rows - sizeBase; i = i + step_x) {
-        for (int j = 0; j <= image.cols - sizeBase; j = j + step_y) {
+const std::vector < double > & FLAT_CASCADE_EVALUATION::getRejectionTraces() const {
+  return treeRejection;
+}
 
-          /*__________ CALCULATING THE WINDOW POSITION __________*/
-          int topLeft_x = i;
-          int topLeft_y = j;
-          int bottomRight_x = sizeBase + i - 1;
-          int bottomRight_y = sizeBase + j - 1;
-          /*____________________________________________________________*/
+void FLAT_CASCADE_EVALUATION::setFlagRejectionTraces(bool rejectionTraces) {
+  flagRejectionTraces = rejectionTraces && !treeRejection.empty();
+}
 
-          cv::Mat window;
-          window = imageGray(cv::Range(topLeft_x, bottomRight_x + 1), cv::Range(topLeft_y, bottomRight_y + 1));
+int FLAT_CASCADE_EVALUATION::evaluate(const uchar * window, const int * offsets, int beginStage, int endStage, double * score) const {
 
-          //___________________________________________________________________________________________//
-          double sum2 = integralBw.at < int > (bottomRight_x + 1, bottomRight_y + 1) + integralBw.at < int > (topLeft_x, topLeft_y) - (integralBw.at < int > (bottomRight_x + 1, topLeft_y) + integralBw.at < int > (topLeft_x, bottomRight_y + 1)); // Integral image evaluation
+  for (int s = beginStage; s < endStage; s++) {
 
-          if (sum2 > 76.5 * sizeBase * sizeBase) { // 76.5 = 255 * 0.3
+    double evaluation = evaluateStage(window, offsets, s);
 
-            for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
-              if (evaluateClassifier(window, idx, orderDegrees)) {
+    if (score != NULL) * score = evaluation;
+    if (evaluation < stageThreshold[s]) return s; /*Classified as negative*/
 
-                cv::Rect rectTemp(j, i, sizeBase, sizeBase);
-                windowsCandidates.push_back(rectTemp);
+  }
 
-              }
-            }
+  return endStage; /*Classified as positive*/
 
-          }
-          //___________________________________________________________________________________________//
+}
 
-        }
-      }
+double FLAT_CASCADE_EVALUATION::evaluateStageClamped(const cv::Mat & image, int row, int col, int kx, int ky, const short * coordinates, int stage) const {
 
-    }
-    //_____________________________________________________________________________________________________________________//
+  const double * rejection = flagRejectionTraces ? & treeRejection[0] : NULL;
 
-  } else {
+  const int * children = & nodeChildren[0];
+  const int * tests = & nodeSplitTest[0];
+  const double * leaves = & leafValue[0];
+  int lastRow = image.rows - 1, lastCol = image.cols - 1;
 
-    //_______________________________________________________________________________________________________________________//
-    for (int sizeBase = sizeBaseEvaluation; sizeBase <= std::min(image.rows, image.cols); sizeBase = factorScaleWindow * sizeBase, idx++) {
-      int step_x = sizeBase * stepWindow; /* In this factor, the search window will move in rows */
-      int step_y = sizeBase * stepWindow; /* In this factor, the search window will move in columns */
-      for (int i = 0; i <= image.rows - sizeBase; i = i + step_x) {
-        for (int j = 0; j <= image.cols - sizeBase; j = j + step_y) {
+  double evaluation = 0;
 
-          /*__________ CALCULATING THE WINDOW POSITION __________*/
-          int topLeft_x = i;
-          int topLeft_y = j;
-          int bottomRight_x = sizeBase + i - 1;
-          int bottomRight_y = sizeBase + j - 1;
-          /*____________________________________________________________*/
+  for (int t = stageTreeBegin[stage]; t < stageTreeBegin[stage + 1]; t++) {
+
+    int node = treeRoot[t];
+    while (node >= 0) {
+      const short * c = coordinates + 4 * node;
+      int row1 = std::min(std::max(row + ky * c[0], 0), lastRow), col1 = std::min(std::max(col + kx * c[1], 0), lastCol);
+      int row2 = std::min(std::max(row + ky * c[2], 0), lastRow), col2 = std::min(std::max(col + kx * c[3], 0), lastCol);
+      int p1 = image.ptr < uchar > (row1)[col1];
+      int p2 = image.ptr < uchar > (row2)[col2];
+      const int * test = tests + 3 * node;
+      node = children[2 * node + (test[0] * p1 - test[1] * p2 > test[2])];
+    }
+    evaluation = evaluation + leaves[~node];
 
-          cv::Mat window;
-          window = imageGray(cv::Range(topLeft_x, bottomRight_x + 1), cv::Range(topLeft_y, bottomRight_y + 1));
+    if (rejection != NULL && evaluation < rejection[t]) return -HUGE_VAL;
 
-          //___________________________________________________________________________________________//
+  }
 
-          for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
-            if (evaluateClassifier(window, idx, orderDegrees)) {
+  return evaluation;
+}
 
-              cv::Rect rectTemp(j, i, sizeBase, sizeBase);
-              windowsCandidates.push_back(rectTemp);
+int FLAT_CASCADE_EVALUATION::evaluateClamped(const cv::Mat & image, int row, int col, int kx, int ky, const short * coordinates, int beginStage, int endStage, double * score) const {
 
-            }
-          }
-          //___________________________________________________________________________________________//
+  for (int s = beginStage; s < endStage; s++) {
 
-        }
-      }
+    double evaluation = evaluateStageClamped(image, row, col, kx, ky, coordinates, s);
 
+    if (score != NULL) * score = evaluation;
+    if (evaluation < stageThreshold[s]) return s;
+
+  }
+
+  return endStage;
+
+}
+
+#if defined(__AVX2__)
+/*Evaluates one stage on 8 windows at once, every lane walks its own path through each tree using gathers. The sums are accumulated in
+tree order, so each lane gives exactly the same value as evaluateStage*/
+void FLAT_CASCADE_EVALUATION::evaluateStage8(const uchar * base, const int * offsets, const int * windows, int stage, double * sums) const {
+
+  const double * rejection = flagRejectionTraces ? & treeRejection[0] : NULL;
+  const __m256d rejected = _mm256_set1_pd(-HUGE_VAL);
+
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i minusOne = _mm256_set1_epi32(-1);
+  const __m256i maskPixel = _mm256_set1_epi32(0xFF);
+  const __m256i windowsOffsets = _mm256_loadu_si256((const __m256i * ) windows);
+
+  __m256d sumLow = _mm256_setzero_pd();
+  __m256d sumHigh = _mm256_setzero_pd();
+
+  for (int t = stageTreeBegin[stage]; t < stageTreeBegin[stage + 1]; t++) {
+
+    __m256i node = _mm256_set1_epi32(treeRoot[t]);
+    __m256i active = _mm256_cmpgt_epi32(node, minusOne);
+
+    while (!_mm256_testz_si256(active, active)) {
+
+      __m256i node2 = _mm256_slli_epi32(node, 1);
+      __m256i offset1 = _mm256_add_epi32(windowsOffsets, _mm256_mask_i32gather_epi32(zero, offsets, node2, active, 4));
+      __m256i offset2 = _mm256_add_epi32(windowsOffsets, _mm256_mask_i32gather_epi32(zero, offsets + 1, node2, active, 4));
+
+      /*Each pixel is read as the low byte of a 32 bit load, the extra row after imageGray keeps the three extra bytes inside the buffer*/
+      __m256i p1 = _mm256_and_si256(_mm256_mask_i32gather_epi32(zero, (const int * ) base, offset1, active, 1), maskPixel);
+      __m256i p2 = _mm256_and_si256(_mm256_mask_i32gather_epi32(zero, (const int * ) base, offset2, active, 1), maskPixel);
+
+      __m256i node3 = _mm256_add_epi32(node2, node);
+      __m256i a = _mm256_mask_i32gather_epi32(zero, & nodeSplitTest[0], node3, active, 4);
+      __m256i b = _mm256_mask_i32gather_epi32(zero, & nodeSplitTest[1], node3, active, 4);
+      __m256i c = _mm256_mask_i32gather_epi32(zero, & nodeSplitTest[2], node3, active, 4);
+      __m256i right = _mm256_cmpgt_epi32(_mm256_sub_epi32(_mm256_mullo_epi32(a, p1), _mm256_mullo_epi32(b, p2)), c); /*-1 where the NPD is above the threshold*/
+
+      node = _mm256_mask_i32gather_epi32(node, & nodeChildren[0], _mm256_sub_epi32(node2, right), active, 4);
+      active = _mm256_cmpgt_epi32(node, minusOne);
+
+    }
+
+    __m256i leaf = _mm256_sub_epi32(minusOne, node); /*~node*/
+    sumLow = _mm256_add_pd(sumLow, _mm256_i32gather_pd( & leafValue[0], _mm256_castsi256_si128(leaf), 8));
+    sumHigh = _mm256_add_pd(sumHigh, _mm256_i32gather_pd( & leafValue[0], _mm256_extracti128_si256(leaf, 1), 8));
+
+    if (rejection != NULL) { // The lanes below the trace become -infinity, and the stage ends when all of them are
+      __m256d trace = _mm256_set1_pd(rejection[t]);
+      sumLow = _mm256_blendv_pd(sumLow, rejected, _mm256_cmp_pd(sumLow, trace, _CMP_LT_OQ));
+      sumHigh = _mm256_blendv_pd(sumHigh, rejected, _mm256_cmp_pd(sumHigh, trace, _CMP_LT_OQ));
+      if (_mm256_movemask_pd(_mm256_cmp_pd(sumLow, rejected, _CMP_EQ_OQ)) == 0xF && _mm256_movemask_pd(_mm256_cmp_pd(sumHigh, rejected, _CMP_EQ_OQ)) == 0xF) break;
+    }
+
+  }
+
+  _mm256_storeu_pd(sums, sumLow);
+  _mm256_storeu_pd(sums + 4, sumHigh);
+
+}
+#endif
+
+int FLAT_CASCADE_EVALUATION::evaluateBreadthFirst(const uchar * base, const int * offsets, int * windows, double * scores, int numberWindows, int endStage, long long * rejectedByStage) const {
+
+  for (int s = 0; s < endStage && numberWindows > 0; s++) {
+
+    /*The survivors are compacted at the beginning of windows, keeping their order*/
+    int survivors = 0;
+    int k = 0;
+
+    #if defined(__AVX2__)
+    double sums[8];
+    for (; (generatedStages == NULL || flagRejectionTraces) && k + 8 <= numberWindows; k = k + 8) {
+      evaluateStage8(base, offsets, windows + k, s, sums);
+      for (int l = 0; l < 8; l++) {
+        if (sums[l] >= stageThreshold[s]) {
+          windows[survivors] = windows[k + l];
+          scores[survivors] = sums[l];
+          survivors++;
+        }
+      }
+    }
+    #endif
+
+    for (; k < numberWindows; k++) {
+      double evaluation = evaluateStage(base + windows[k], offsets, s);
+      if (evaluation >= stageThreshold[s]) {
+        windows[survivors] = windows[k];
+        scores[survivors] = evaluation;
+        survivors++;
+      }
+    }
+
+    if (rejectedByStage != NULL) rejectedByStage[s] += numberWindows - survivors;
+    numberWindows = survivors;
+
+  }
+
+  return numberWindows;
+
+}
+
+CASCADE_CLASSIFIERS_EVALUATION::CASCADE_CLASSIFIERS_EVALUATION(std::string nameFile): widthImages(0),
+highImages(0),
+sizeBaseEvaluation(0), // No scale is scanned if the cascade could not be loaded
+numberGraphNodes(0) {
+
+  if (isBinaryCascadeFile(nameFile))
+    loadBinaryCascade(nameFile);
+  else {
+    fileCascadeClassifier = new cv::FileStorage(nameFile, cv::FileStorage::READ);
+    loadCascadeClasifier();
+  }
+  loadRejectionTraces(nameFile + ".traces.xml"); // If the calibration file exists next to the model, it is loaded but not activated
+  SCAN_MASK scanMask;
+  if (scanMask.load(nameFile + ".mask.xml")) defaultContext.setScanMask(scanMask); // The scan mask of a camera, if it exists next to the model
+
+  //______________THIS SHOULD BE DONE AFTER LOADING THE FULL CLASSIFIER_____________________
+  degrees.push_back(0); // Zero degrees
+  factorScaleWindow = 1.2; // 1.2 was the value that worked best in tests
+  stepWindow = 0.2; // 0.2 was the value that worked best in tests
+  sizeMaxWindow = 4096; // Only limits the windows, the images may be larger (a face that fills a 4K frame is still found)
+  sizeTile = 2048;
+  initializeFeatures(); // Features are initialized with the previous parameters
+  //_______________________________________________________________________________________________
+
+  //______Other default parameters__________//
+  lineThicknessRectangles = 1;
+  colorRectangles = cv::Scalar(0, 255, 0); // Default color is green
+  groupThreshold = 1;
+  eps = 0.2;
+  flagActivateSkinColor = false; // By default, skin color is not activated
+  hsvMin = cv::Scalar(0, 10, 60); // Minimum value, works very well
+  hsvMax = cv::Scalar(20, 150, 255); // Maximum value, works very well
+  flagExtractColorImages = false; // By default, detected regions are returned in grayscale
+  flagParallelScan = true; // By default, the scan is distributed among all the cores
+  evaluationEngine = EVALUATION_ENGINE_DEPTH_FIRST;
+  flagPyramid = false;
+  flagCoarseToFine = false;
+  coarseStep = 2;
+  coarseStages = 2;
+  refinementRadius = 1;
+  flagAnglePruning = false;
+  anglePruningMargin = 1;
+  flagLargestObject = false;
+  minSizeObject = 0;
+  maxSizeObject = INT_MAX;
+
+  numberClassifiersUsed = flatCascade.getNumberStages();
+
+  //____________________________________________//
+
+}
+
+CASCADE_CLASSIFIERS_EVALUATION::~CASCADE_CLASSIFIERS_EVALUATION() {
+
+  // We delete the dynamic memory for the strongLearns
+  for (int i = 0; i < strongLearnsEvaluation.size(); i++)
+    delete strongLearnsEvaluation[i];
+  strongLearnsEvaluation.clear();
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::initializeFeatures() {
+
+  /*Every call gets a version that no other cascade has, the contexts compare it with the one of their buffers*/
+  static int numberInitializations = 0;
+  featuresVersion = ++numberInitializations;
+
+  /*The scales visited by the detection functions, each context keeps the offsets of the ones that fit in its images for their stride*/
+  scaleSizes.clear();
+  for (int sizeBase = sizeBaseEvaluation; sizeBase > 0 && sizeBase <= sizeMaxWindow; sizeBase = factorScaleWindow * sizeBase)
+    scaleSizes.push_back(sizeBase);
+
+  flatCascade.computeCoordinates(degrees, widthImages, highImages, featureCoordinates, featureFootprint);
+
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 1
+  /*The graph has the same split nodes as flatCascade, so its arena is allocated once and each node fills its own entries*/
+  numberGraphNodes = flatCascade.getNumberSplitNodes();
+  graphFeatures.assign(4 * numberGraphNodes * degrees.size(), 0);
+  int nextNode = 0;
+  for (int i = 0; i < strongLearnsEvaluation.size(); i++)
+    strongLearnsEvaluation[i] -> initializeFeatures(nextNode);
+  #endif
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setDegreesDetections(std::vector < double > myDegrees) {
+  degrees = myDegrees;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setSizeBase(int sizeBase) {
+  sizeBaseEvaluation = sizeBase;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFactorScaleWindow(double factorScale) {
+  factorScaleWindow = factorScale;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setStepWindow(double factorStep) {
+  stepWindow = factorStep;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setSizeMaxWindow(double maxSize) {
+  sizeMaxWindow = maxSize;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFlagPyramid(bool pyramid) {
+  flagPyramid = pyramid;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setLineThicknessRectangles(int thicknessRectangles) {
+
+  lineThicknessRectangles = thicknessRectangles;
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setColorRectangles(const cv::Scalar & color) {
+
+  colorRectangles = color;
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setGroupThreshold(int threshold) {
+  groupThreshold = threshold;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setEps(double myEps) {
+  eps = myEps;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFlagActivateSkinColor(bool activateSkinColor) {
+  flagActivateSkinColor = activateSkinColor;
+  updateSkinLookup();
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFlagExtractColorImages(bool extractColorImages) {
+  flagExtractColorImages = extractColorImages;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setNumberClassifiersUsed(int number) {
+
+  if (number < 1)
+    numberClassifiersUsed = 1;
+  else if (number > flatCascade.getNumberStages())
+    numberClassifiersUsed = flatCascade.getNumberStages();
+  else
+    numberClassifiersUsed = number;
+
+}
+
+const SCAN_STATISTICS & CASCADE_CLASSIFIERS_EVALUATION::getScanStatistics() const {
+  return defaultContext.getScanStatistics();
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::clearScanStatistics() {
+  defaultContext.clearScanStatistics();
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setSizeExtractedObjects(const cv::Size & size) {
+  sizeExtractedObjects = size;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFlagParallelScan(bool parallelScan) {
+  flagParallelScan = parallelScan;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setEvaluationEngine(int engine) {
+  evaluationEngine = engine;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFlagCoarseToFine(bool coarseToFine) {
+  flagCoarseToFine = coarseToFine;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setCoarseStep(int step) {
+  coarseStep = std::max(1, step);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setCoarseStages(int stages) {
+  coarseStages = std::max(1, stages);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setRefinementRadius(int radius) {
+  refinementRadius = std::max(0, radius);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFlagAnglePruning(bool anglePruning) {
+  flagAnglePruning = anglePruning;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setAnglePruningMargin(double margin) {
+  anglePruningMargin = margin;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFlagLargestObject(bool largestObject) {
+  flagLargestObject = largestObject;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setSizeLimitsObject(int minSize, int maxSize) {
+  minSizeObject = std::max(0, minSize);
+  maxSizeObject = (maxSize > 0) ? maxSize : INT_MAX;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setSizeTile(int size) {
+  sizeTile = std::max(size, 4 * sizeBaseEvaluation);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setHsvMin(const cv::Scalar & hsv) {
+  hsvMin = hsv;
+  updateSkinLookup();
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setHsvMax(const cv::Scalar & hsv) {
+  hsvMax = hsv;
+  updateSkinLookup();
+}
+
+int CASCADE_CLASSIFIERS_EVALUATION::getNumberStrongLearns() const {
+  return flatCascade.getNumberStages();
+}
+
+double CASCADE_CLASSIFIERS_EVALUATION::getSizeMaxWindow() const {
+  return sizeMaxWindow;
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::hasSameWindows(const CASCADE_CLASSIFIERS_EVALUATION & other) const {
+  return other.widthImages == widthImages && other.highImages == highImages;
+}
+
+cv::Scalar CASCADE_CLASSIFIERS_EVALUATION::getHsvMin() const {
+  return hsvMin;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::generateCascadeCode(std::ostream & out) const {
+  flatCascade.generateCode(out);
+}
+
+cv::Scalar CASCADE_CLASSIFIERS_EVALUATION::getHsvMax() const {
+  return hsvMax;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::reportMemory(std::ostream & out) const {
+
+  out << "Trees: " << flatCascade.getModelBytes() << " bytes (" << flatCascade.getNumberStages() << " stages, " << flatCascade.getNumberSplitNodes() << " split nodes)\n";
+  out << "Feature coordinates: " << bytesOf(featureCoordinates) << " bytes (" << degrees.size() << " degrees)\n";
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 1
+  out << "Coordinates of the object graph: " << bytesOf(graphFeatures) << " bytes\n";
+  #endif
+  out << "Skin color lookup: " << bytesOf(skinLookup) << " bytes\n";
+  out << "Default detection context: " << defaultContext.getBytes() << " bytes\n";
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::loadCascadeClasifier() {
+
+  /* ____________________ Here begins the classifier reading ________________________ */
+
+  cv::FileNode information = (*fileCascadeClassifier)["information"];
+
+  /*__________ HERE IMPORTANT VARIABLES ARE UPDATED __________*/
+
+  widthImages = (int) information["G_WIDTH_IMAGE"];
+  highImages = (int) information["G_HEIGHT_IMAGE"];
+  sizeBaseEvaluation = std::min(widthImages, highImages); // By default, its size is the smaller side of the image size
+
+  /*_______________________________________________________________*/
+
+  /* Next, each strong learn is loaded and compiled into the flat representation */
+  cv::FileNode cascade_classifiers = (*fileCascadeClassifier)["cascade_classifiers"];
+  strongLearnsEvaluation.reserve(cascade_classifiers.size());
+  flatCascade.clear();
+
+  for (int i = 0; i < cascade_classifiers.size(); i++) {
+    STRONG_LEARN_EVALUATION* strongLearnAux = new STRONG_LEARN_EVALUATION(this);
+    strongLearnAux->loadStrongLearn(cascade_classifiers, i); /* Here each classifier is loaded */
+    strongLearnsEvaluation.push_back(strongLearnAux);
+    flatCascade.compileStrongLearn(strongLearnAux);
+  }
+  std::cout << "Cascade loaded: " << flatCascade.getNumberStages() << " strong classifiers, " << flatCascade.getNumberTrees() << " trees\n";
+
+  fileCascadeClassifier->release();
+  if (fileCascadeClassifier != NULL) delete fileCascadeClassifier;
+
+  prepareFlatCascade();
+
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::isBinaryCascadeFile(const std::string & nameFile) {
+
+  char magic[sizeof(binaryCascadeMagic)];
+  std::ifstream file(nameFile.c_str(), std::ios::binary);
+
+  return file.read(magic, sizeof(magic)) && std::memcmp(magic, binaryCascadeMagic, sizeof(magic)) == 0;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::loadBinaryCascade(const std::string & nameFile) {
+
+  bool loaded = false;
+
+  #if defined(_WIN32)
+  std::ifstream file(nameFile.c_str(), std::ios::binary);
+  std::vector < char > data((std::istreambuf_iterator < char > (file)), std::istreambuf_iterator < char > ());
+  if (!data.empty()) loaded = flatCascade.readBinary( & data[0], data.size(), widthImages, highImages);
+  #else
+  /*The file is mapped instead of read, the arrays are copied straight from the page cache into flatCascade*/
+  int fd = open(nameFile.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat information;
+    if (fstat(fd, & information) == 0 && information.st_size > 0) {
+      void * data = mmap(NULL, information.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        loaded = flatCascade.readBinary((const char * ) data, information.st_size, widthImages, highImages);
+        munmap(data, information.st_size);
+      }
+    }
+    close(fd);
+  }
+  #endif
+
+  if (!loaded) {
+    std::cout << "The binary cascade " << nameFile << " could not be loaded\n";
+    return;
+  }
+
+  sizeBaseEvaluation = std::min(widthImages, highImages); // By default, its size is the smaller side of the image size
+  prepareFlatCascade();
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::prepareFlatCascade() {
+
+  #if VALIDATE_INTEGER_SPLIT_TESTS == 1
+  flatCascade.validateIntegerSplitTests();
+  #endif
+
+  #if defined(UVFACE_GENERATED_CASCADE)
+  if (!flatCascade.attachGeneratedStages(GENERATED_CASCADE_STAGES, GENERATED_CASCADE_NUMBER_STAGES, GENERATED_CASCADE_FINGERPRINT))
+    std::cout << "The generated cascade was not built from this file, the flat cascade will be used\n";
+  #endif
+
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::calibrateRejectionTraces(const std::vector < cv::Mat > & positives) {
+
+  if (flatCascade.getNumberTrees() == 0) return false;
+
+  std::vector < double > traces(flatCascade.getNumberTrees(), HUGE_VAL);
+  std::vector < double > partialSums(flatCascade.getNumberTrees());
+
+  /*The windows are evaluated at their native size, with a zero degrees offset table for the stride of the resized window*/
+  std::vector < double > zeroDegrees(1, 0);
+  std::vector < int > nativeScale(1, 1);
+  std::vector < int > offsets;
+  cv::Mat window(highImages, widthImages, CV_8UC1);
+  flatCascade.computeOffsets(zeroDegrees, nativeScale, nativeScale, widthImages, highImages, window.step, offsets);
+
+  int numberPassed = 0;
+  for (int i = 0; i < positives.size(); i++) {
+
+    cv::Mat gray = positives[i];
+    if (gray.channels() == 3) cvtColor(positives[i], gray, CV_BGR2GRAY);
+    cv::resize(gray, window, window.size(), 0, 0, (gray.cols > widthImages) ? cv::INTER_AREA : cv::INTER_LINEAR);
+
+    if (!flatCascade.traceWindow(window.ptr < uchar > (), & offsets[0], & partialSums[0])) continue; // Positives rejected by the cascade do not constrain the traces
+
+    for (int t = 0; t < traces.size(); t++)
+      traces[t] = std::min(traces[t], partialSums[t]);
+    numberPassed++;
+
+  }
+
+  std::cout << numberPassed << " of " << positives.size() << " positive windows passed the cascade and were used for the calibration\n";
+
+  if (numberPassed == 0) return false;
+
+  return flatCascade.setRejectionTraces(traces);
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::saveRejectionTraces(const std::string & nameFile) const {
+
+  if (flatCascade.getRejectionTraces().empty()) return false;
+
+  cv::FileStorage file(nameFile, cv::FileStorage::WRITE);
+  if (!file.isOpened()) return false;
+
+  file << "fingerprint" << (int) flatCascade.getFingerprint(); // Identifies the cascade the traces were calibrated for
+  file << "treeRejection" << cv::Mat(flatCascade.getRejectionTraces());
+  file.release();
+
+  return true;
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::loadRejectionTraces(const std::string & nameFile) {
+
+  cv::FileStorage file(nameFile, cv::FileStorage::READ);
+  if (!file.isOpened()) return false;
+
+  if ((unsigned int)(int) file["fingerprint"] != flatCascade.getFingerprint()) {
+    std::cout << "The rejection traces " << nameFile << " were calibrated for another cascade\n";
+    return false;
+  }
+
+  cv::Mat traces;
+  file["treeRejection"] >> traces;
+
+  return traces.type() == CV_64FC1 && traces.isContinuous() && flatCascade.setRejectionTraces(std::vector < double > (traces.ptr < double > (), traces.ptr < double > () + traces.total()));
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setFlagRejectionTraces(bool rejectionTraces) {
+  flatCascade.setFlagRejectionTraces(rejectionTraces);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::setScanMask(const SCAN_MASK & mask) {
+  defaultContext.setScanMask(mask);
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::saveBinaryCascade(const std::string & nameFile) const {
+
+  std::ofstream file(nameFile.c_str(), std::ios::binary);
+  if (!file) return false;
+
+  flatCascade.writeBinary(file, widthImages, highImages);
+
+  return (bool) file;
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::evaluateClassifier(cv::Mat& image, int scale, int orderDegrees) {
+
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 1
+  for (int i = 0; i < numberClassifiersUsed; i++)
+    if (!strongLearnsEvaluation[i]->evaluateStrongLearn(image, scale, orderDegrees)) return false; /* Classified as negative label */
+
+  return true; /* Classified as positive label */
+  #else
+  return evaluateClassifier(image.ptr < uchar > (), scale, orderDegrees);
+  #endif
+
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::evaluateClassifier(cv::Mat& image, int scale, int orderDegrees, int begin, int end) {
+
+  if (flatCascade.evaluate(image.ptr < uchar > (), getWindowOffsets(defaultContext, scale, orderDegrees), begin, end, & scoreDetection) < end)
+    return false; /* Classified as negative label */
+
+  return true; /* Classified as positive label */
+
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::evaluateClassifier(const uchar * window, int scale, int orderDegrees) {
+
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 1
+  cv::Mat windowGraph(highImages, widthImages, CV_8UC1, const_cast < uchar * > (window), defaultContext.imageGray.step); // Only a header, at() must see the stride of imageGray
+  return evaluateClassifier(windowGraph, scale, orderDegrees);
+  #else
+  return flatCascade.evaluate(window, getWindowOffsets(defaultContext, scale, orderDegrees), 0, numberClassifiersUsed) == numberClassifiersUsed;
+  #endif
+
+}
+
+// __________________________________ SLIDING WINDOW SCAN __________________________________
+
+/*Number of rows of windows of the same scale that form a work item of the scan*/
+static const int rowsPerWorkItem = 8;
+
+/*A band of rows of windows of a single scale, it is the unit of work distributed among the threads during the scan. The windows are scanned
+in image, which is imageGray or, in pyramid mode, the level of the pyramid of the scale*/
+class SCAN_WORK_ITEM {
+  public: SCAN_WORK_ITEM(int scale, int sizeBase, const cv::Mat * image, int widthWindow, int highWindow, int stepRows, int stepCols, int firstRow, int lastRow, int firstCol, int lastCol, int originRow = 0, int originCol = 0): scale(scale),
+  sizeBase(sizeBase),
+  image(image),
+  widthWindow(widthWindow),
+  highWindow(highWindow),
+  stepRows(stepRows),
+  stepCols(stepCols),
+  firstRow(firstRow),
+  lastRow(lastRow),
+  firstCol(firstCol),
+  lastCol(lastCol),
+  originRow(originRow),
+  originCol(originCol),
+  statistics(NULL) {}
+  int scale; //Index of the scale in the offset tables (or of the level in pyramidLevels)
+  int sizeBase; //Side of the windows in the input image
+  const cv::Mat * image; //Image where the windows are evaluated
+  int widthWindow; //Width of the windows in image
+  int highWindow; //Height of the windows in image
+  int stepRows; //In this factor, the search window will move in rows of image
+  int stepCols; //In this factor, the search window will move in columns of image
+  int firstRow; //Top row (in image) of the first window of the band
+  int lastRow; //The band contains the windows whose top row is in [firstRow, lastRow]
+  int firstCol; //Left column (in image) of the first window of each row
+  int lastCol; //The band contains the windows whose left column is in [firstCol, lastCol]
+  int originRow; //The windows are at the rows and columns p of image such that p + origin is a multiple of the step (see SEARCH_REGION::origin)
+  int originCol;
+  SCAN_STATISTICS * statistics; //Counters of the item, only used when UVFACE_SCAN_STATISTICS is defined
+};
+
+/*A cascade evaluated by the multi-model scan, with the tables of its features for the degrees and scales of the cascade that scans*/
+class SCAN_MODEL {
+  public: SCAN_MODEL(int id, const FLAT_CASCADE_EVALUATION * cascade, int numberStages, const std::vector < int > * offsets, bool pyramid, int numberScales, const std::vector < short > * coordinates, const cv::Rect & footprint): id(id),
+  cascade(cascade),
+  numberStages(numberStages),
+  offsets(offsets),
+  pyramid(pyramid),
+  numberScales(numberScales),
+  coordinates(coordinates),
+  footprint(footprint) {}
+  int id; //Model id returned by detectObjectRectanglesMultiModel
+  const FLAT_CASCADE_EVALUATION * cascade;
+  int numberStages; //Stages used, the numberClassifiersUsed of its cascade
+  const std::vector < int > * offsets; //[degree][scale][node][2] for the stride of imageGray, or [degree][node][2] for pyramidBackground if pyramid is true
+  bool pyramid;
+  int numberScales;
+  const std::vector < short > * coordinates; //[degree][node][4], see FLAT_CASCADE_EVALUATION::computeCoordinates
+  cv::Rect footprint;
+
+  /*Same as CASCADE_CLASSIFIERS_EVALUATION::evaluateWindow for the whole cascade of the model*/
+  int evaluate(const SCAN_WORK_ITEM & item, bool inside, int row, int col, int orderDegrees, int kx, int ky, double * score) const {
+    int numberNodes = cascade -> getNumberSplitNodes();
+    if (inside) {
+      const int * windowOffsets = & (* offsets)[2 * (pyramid ? orderDegrees : orderDegrees * numberScales + item.scale) * numberNodes];
+      return cascade -> evaluate(item.image -> ptr < uchar > (row) + col, windowOffsets, 0, numberStages, score);
+    }
+    return cascade -> evaluateClamped( * item.image, row, col, kx, ky, & (* coordinates)[4 * orderDegrees * numberNodes], 0, numberStages, score);
+  }
+};
+
+void SCAN_STATISTICS::clear(int numberStages) {
+  * this = SCAN_STATISTICS();
+  rejectedByStage.assign(numberStages, 0);
+}
+
+void SCAN_STATISTICS::countWindow(int stageReached, int endStage) {
+  windows++;
+  if (stageReached < endStage) rejectedByStage[stageReached]++;
+}
+
+void SCAN_STATISTICS::countWindowOtherModel(int treesEvaluated) {
+  windows++;
+  windowsOtherModels++;
+  trees = trees + treesEvaluated;
+}
+
+void SCAN_STATISTICS::add(const SCAN_STATISTICS & statistics) {
+  windows = windows + statistics.windows;
+  windowsOtherModels = windowsOtherModels + statistics.windowsOtherModels;
+  if (rejectedByStage.size() < statistics.rejectedByStage.size()) rejectedByStage.resize(statistics.rejectedByStage.size(), 0);
+  for (int s = 0; s < statistics.rejectedByStage.size(); s++)
+    rejectedByStage[s] = rejectedByStage[s] + statistics.rejectedByStage[s];
+
+  trees = trees + statistics.trees;
+  scans = scans + statistics.scans;
+  if (windowsByScale.size() < statistics.windowsByScale.size()) {
+    windowsByScale.resize(statistics.windowsByScale.size(), 0);
+    secondsByScale.resize(statistics.windowsByScale.size(), 0);
+  }
+  for (int s = 0; s < statistics.windowsByScale.size(); s++) {
+    windowsByScale[s] = windowsByScale[s] + statistics.windowsByScale[s];
+    secondsByScale[s] = secondsByScale[s] + statistics.secondsByScale[s];
+  }
+  secondsScan = secondsScan + statistics.secondsScan;
+  secondsGrouping = secondsGrouping + statistics.secondsGrouping;
+}
+
+long long SCAN_STATISTICS::getWindowsEntering(int stage) const {
+  long long entering = windows - windowsOtherModels;
+  for (int s = 0; s < stage && s < rejectedByStage.size(); s++)
+    entering = entering - rejectedByStage[s];
+  return entering;
+}
+
+const SCAN_STATISTICS & DETECTION_CONTEXT::getScanStatistics() const {
+  return scanStatistics;
+}
+
+void DETECTION_CONTEXT::clearScanStatistics() {
+  scanStatistics = SCAN_STATISTICS(); // The counters of the stages are added by the next scan
+}
+
+void DETECTION_CONTEXT::setScanMask(const SCAN_MASK & mask) {
+  scanMask = mask;
+  scanMaskChanged = true;
+}
+
+size_t DETECTION_CONTEXT::getBytes() const {
+  size_t bytes = bytesOf(featureOffsets) + bytesOf(pyramidOffsets) + bytesOf(windowsCandidates) + bytesOf(windowsCandidatesRotated) + bytesOf(maskRows);
+  for (int s = 0; s < maskColumns.size(); s++)
+    bytes = bytes + bytesOf(maskColumns[s]);
+  for (int m = 0; m < modelOffsets.size(); m++)
+    bytes = bytes + bytesOf(modelOffsets[m]) + bytesOf(modelCoordinates[m]);
+  bytes = bytes + scanMask.mask.total();
+  const cv::Mat * buffers[] = { & imageBuffer, & integralBw, & integralBlocks, & pyramidBackground };
+  for (int k = 0; k < 4; k++)
+    bytes = bytes + buffers[k] -> total() * buffers[k] -> elemSize();
+  return bytes;
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::allocateBuffers(const cv::Size & size, DETECTION_CONTEXT & context) const {
+
+  /*The buffers depend on the size of the image and on the features of the cascade (scales and degrees)*/
+  bool newSize = (context.szImg != size || context.featuresVersion != featuresVersion);
+
+  if (newSize) {
+
+    context.imageBuffer.create(size.height + 1, size.width, CV_8UC1);
+    context.imageGray = context.imageBuffer.rowRange(0, size.height);
+    context.szImg = size;
+    context.featuresVersion = featuresVersion;
+
+    /*The offsets of the scales whose windows fit in the image, for the stride of imageGray*/
+    std::vector < int > kx, ky;
+    for (int s = 0; s < scaleSizes.size() && scaleSizes[s] <= std::min(size.height, size.width); s++) {
+      kx.push_back(scaleSizes[s] / widthImages);
+      ky.push_back(scaleSizes[s] / highImages);
+    }
+    context.numberScales = kx.size();
+    flatCascade.computeOffsets(degrees, kx, ky, widthImages, highImages, context.imageGray.step, context.featureOffsets);
+    context.modelCascades.clear(); // The tables of the multi-model scan are computed again by the next one
+
+  }
+
+  if (newSize || context.scanMaskChanged) computeScanMask(context);
+
+  return newSize;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::preprocessImage(const cv::Mat & image, DETECTION_CONTEXT & context) const {
+
+  bool newSize = allocateBuffers(image.size(), context);
+
+  if (flagActivateSkinColor)
+    preprocessSkinColor(image, context); // Grayscale, skin mask and its integrals in a single pass
+  else
+    cvtColor(image, context.imageGray, CV_BGR2GRAY); // Converting to grayscale
+  context.skinColor = flagActivateSkinColor;
+
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 0
+  if (flagPyramid) buildPyramid(context, newSize);
+  #endif
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::preprocessLuma(const cv::Mat & luma, DETECTION_CONTEXT & context) const {
+
+  bool newSize = allocateBuffers(luma.size(), context);
+
+  luma.copyTo(context.imageGray); // Row by row, imageGray has its own stride and the extra row of imageBuffer
+  context.skinColor = false;
+
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 0
+  if (flagPyramid) buildPyramid(context, newSize);
+  #endif
+
+}
+
+bool SCAN_MASK::load(const std::string & nameFile) {
+
+  * this = SCAN_MASK();
+
+  cv::FileStorage file(nameFile, cv::FileStorage::READ);
+  if (!file.isOpened()) return false;
+
+  minSizeTop = (double) file["minSizeTop"];
+  minSizeBottom = (double) file["minSizeBottom"];
+  maxSizeTop = (double) file["maxSizeTop"];
+  maxSizeBottom = (double) file["maxSizeBottom"];
+
+  std::string nameMask = (std::string) file["mask"];
+  if (nameMask.empty()) return true;
+
+  size_t slash = nameFile.find_last_of('/');
+  if (nameMask[0] != '/' && slash != std::string::npos) nameMask = nameFile.substr(0, slash + 1) + nameMask;
+
+  mask = cv::imread(nameMask, 0);
+  if (mask.empty()) {
+    std::cout << "The mask " << nameMask << " of " << nameFile << " could not be read\n";
+    * this = SCAN_MASK();
+    return false;
+  }
+
+  return true;
+}
+
+bool SCAN_MASK::isEmpty() const {
+  return mask.empty() && minSizeTop <= 0 && minSizeBottom <= 0 && maxSizeTop <= 0 && maxSizeBottom <= 0;
+}
+
+bool MOTION_MAP::update(const cv::Mat & frame) {
+
+  /*INTER_AREA averages the pixels of each reduced one, that removes most of the noise of the camera before the comparison*/
+  cv::Size sizeReduced(std::max(1, frame.cols / factor), std::max(1, frame.rows / factor));
+  cv::resize(frame, difference, sizeReduced, 0, 0, cv::INTER_AREA);
+  if (difference.channels() == 3) cv::cvtColor(difference, reduced, CV_BGR2GRAY);
+  else difference.copyTo(reduced);
+
+  int numberBlocksRows = (reduced.rows + blockSize - 1) / blockSize;
+  int numberBlocksCols = (reduced.cols + blockSize - 1) / blockSize;
+
+  if (frame.size() != sizeFrame || background.empty()) {
+    sizeFrame = frame.size();
+    reduced.convertTo(background, CV_32F);
+    blocks = cv::Mat::zeros(numberBlocksRows, numberBlocksCols, CV_8UC1);
+    return false;
+  }
+
+  background.convertTo(difference, CV_8U);
+  cv::absdiff(reduced, difference, difference);
+  cv::threshold(difference, difference, threshold, 255, cv::THRESH_BINARY);
+  cv::accumulateWeighted(reduced, background, learningRate);
+
+  for (int i = 0; i < numberBlocksRows; i++) {
+    for (int j = 0; j < numberBlocksCols; j++) {
+      cv::Rect block = cv::Rect(j * blockSize, i * blockSize, blockSize, blockSize) & cv::Rect(0, 0, reduced.cols, reduced.rows);
+      blocks.at < uchar > (i, j) = (cv::countNonZero(difference(block)) >= minimumFraction * block.area()) ? 255 : 0;
+    }
+  }
+
+  return true;
+}
+
+void MOTION_MAP::getMovingRegions(std::vector < cv::Rect > & regions) const {
+
+  regions.clear();
+  if (blocks.empty()) return;
+
+  double factorRows = double(sizeFrame.height) / reduced.rows;
+  double factorCols = double(sizeFrame.width) / reduced.cols;
+
+  /*The map is small (300 blocks for a 640x480 frame), so the groups are found with a flood fill from each moving block not yet visited*/
+  cv::Mat visited = cv::Mat::zeros(blocks.size(), CV_8UC1);
+  std::vector < cv::Point > pending;
+  for (int i = 0; i < blocks.rows; i++) {
+    for (int j = 0; j < blocks.cols; j++) {
+
+      if (!blocks.at < uchar > (i, j) || visited.at < uchar > (i, j)) continue;
+
+      int top = i, bottom = i, left = j, right = j;
+      visited.at < uchar > (i, j) = 1;
+      pending.push_back(cv::Point(j, i));
+      while (!pending.empty()) {
+        cv::Point block = pending.back();
+        pending.pop_back();
+        top = std::min(top, block.y);
+        bottom = std::max(bottom, block.y);
+        left = std::min(left, block.x);
+        right = std::max(right, block.x);
+        for (int y = std::max(0, block.y - 1); y <= std::min(blocks.rows - 1, block.y + 1); y++) {
+          for (int x = std::max(0, block.x - 1); x <= std::min(blocks.cols - 1, block.x + 1); x++) {
+            if (!blocks.at < uchar > (y, x) || visited.at < uchar > (y, x)) continue;
+            visited.at < uchar > (y, x) = 1;
+            pending.push_back(cv::Point(x, y));
+          }
+        }
+      }
+
+      int x = cvFloor(left * blockSize * factorCols), y = cvFloor(top * blockSize * factorRows);
+      int xEnd = std::min(sizeFrame.width, cvCeil((right + 1) * blockSize * factorCols));
+      int yEnd = std::min(sizeFrame.height, cvCeil((bottom + 1) * blockSize * factorRows));
+      regions.push_back(cv::Rect(x, y, xEnd - x, yEnd - y));
+
+    }
+  }
+
+}
+
+void MOTION_MAP::clear() {
+  sizeFrame = cv::Size();
+  background.release();
+  blocks.release();
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::computeScanMask(DETECTION_CONTEXT & context) const {
+
+  context.maskColumns.clear();
+  context.maskRows.clear();
+  context.scanMaskChanged = false;
+
+  const SCAN_MASK & scanMask = context.scanMask;
+  if (scanMask.isEmpty()) return;
+
+  int rows = context.imageGray.rows, cols = context.imageGray.cols;
+
+  /*First and last nonzero column of each row of the mask at the size of the images*/
+  std::vector < int > firstMask(rows, 0), lastMask(rows, cols - 1);
+  if (!scanMask.mask.empty()) {
+    cv::Mat mask;
+    cv::resize(scanMask.mask, mask, cv::Size(cols, rows), 0, 0, cv::INTER_NEAREST);
+    for (int r = 0; r < rows; r++) {
+      const uchar * row = mask.ptr < uchar > (r);
+      firstMask[r] = cols;
+      lastMask[r] = -1;
+      for (int c = 0; c < cols; c++) {
+        if (row[c] == 0) continue;
+        if (firstMask[r] == cols) firstMask[r] = c;
+        lastMask[r] = c;
+      }
+    }
+  }
+
+  bool limitMax = (scanMask.maxSizeTop > 0 || scanMask.maxSizeBottom > 0);
+  context.maskColumns.resize(context.numberScales);
+  context.maskRows.resize(2 * context.numberScales);
+
+  for (int s = 0; s < context.numberScales; s++) {
+
+    int sizeBase = scaleSizes[s];
+    std::vector < int > & columns = context.maskColumns[s];
+    columns.resize(2 * (rows - sizeBase + 1));
+    int firstRow = rows, lastRow = -1;
+
+    for (int y = 0; y <= rows - sizeBase; y++) {
+
+      int center = y + sizeBase / 2;
+      double position = double(center) / std::max(1, rows - 1);
+      double minSize = scanMask.minSizeTop + (scanMask.minSizeBottom - scanMask.minSizeTop) * position;
+      double maxSize = scanMask.maxSizeTop + (scanMask.maxSizeBottom - scanMask.maxSizeTop) * position;
+
+      /*The windows whose center is between the first and the last pixel of the mask in the row of the center*/
+      int first = std::max(0, firstMask[center] - sizeBase / 2);
+      int last = std::min(cols - sizeBase, lastMask[center] - sizeBase / 2);
+      if (sizeBase < minSize || (limitMax && sizeBase > maxSize)) last = first - 1;
+
+      columns[2 * y] = first;
+      columns[2 * y + 1] = last;
+      if (first <= last) {
+        firstRow = std::min(firstRow, y);
+        lastRow = y;
+      }
+
+    }
+
+    context.maskRows[2 * s] = firstRow;
+    context.maskRows[2 * s + 1] = lastRow;
+
+  }
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::buildPyramid(DETECTION_CONTEXT & context, bool newSize) const {
+
+  const cv::Mat & imageGray = context.imageGray;
+  cv::Mat & pyramidBackground = context.pyramidBackground;
+  std::vector < cv::Mat > & pyramidLevels = context.pyramidLevels;
+
+  if (newSize || pyramidLevels.empty()) {
+
+    /*Sizes of the levels, one per scale visited by scanWindows. In the level of the scale sizeBase a window of sizeBase x sizeBase pixels of
+    the input image becomes a widthImages x highImages window*/
+    std::vector < cv::Size > sizes;
+    for (int s = 0; s < context.numberScales; s++)
+      sizes.push_back(cv::Size(cvRound(double(imageGray.cols) * widthImages / scaleSizes[s]), cvRound(double(imageGray.rows) * highImages / scaleSizes[s])));
+
+    /*The levels are stacked vertically in a single background image, separated by widthImages x highImages borders so that the features of
+    the rotated windows at the edges of a level read zeros. All the levels share the stride, so one offset table is enough*/
+    int widthBackground = 2 * widthImages + (sizes.empty() ? 0 : sizes[0].width);
+    int highBackground = highImages;
+    for (int l = 0; l < sizes.size(); l++)
+      highBackground = highBackground + sizes[l].height + highImages;
+
+    pyramidBackground = cv::Mat::zeros(highBackground, widthBackground, CV_8UC1);
+    pyramidLevels.clear();
+    int row = highImages;
+    for (int l = 0; l < sizes.size(); l++) {
+      pyramidLevels.push_back(pyramidBackground(cv::Range(row, row + sizes[l].height), cv::Range(widthImages, widthImages + sizes[l].width)));
+      row = row + sizes[l].height + highImages;
+    }
+
+    flatCascade.computePyramidOffsets(degrees, widthImages, highImages, pyramidBackground.step, context.pyramidOffsets);
+    context.modelCascades.clear();
+
+  }
+
+  /*Each level is resized directly from imageGray, so the error of the interpolation does not accumulate along the pyramid*/
+  #pragma omp parallel for schedule(dynamic) if (flagParallelScan)
+  for (int l = 0; l < (int) pyramidLevels.size(); l++) {
+    int interpolation = (pyramidLevels[l].cols < imageGray.cols) ? cv::INTER_AREA : cv::INTER_LINEAR;
+    cv::resize(imageGray, pyramidLevels[l], pyramidLevels[l].size(), 0, 0, interpolation);
+  }
+
+}
+
+// __________________________________ SKIN COLOR __________________________________
+
+/*Side of the blocks of integralBlocks, the summary of the skin mask used to discard windows without reading integralBw*/
+static const int skinBlockSize = 8;
+
+void CASCADE_CLASSIFIERS_EVALUATION::buildSkinLookup() {
+
+  /*Each slice of constant R is converted with the same functions used before on the whole image (cvtColor and inRange), so the lookup
+  gives exactly the same mask*/
+  skinLookup.assign(1 << 21, 0);
+
+  cv::Mat slice(256, 256, CV_8UC3), sliceHsv, sliceBw;
+  for (int r = 0; r < 256; r++) {
+
+    for (int g = 0; g < 256; g++) {
+      uchar * pixel = slice.ptr < uchar > (g);
+      for (int b = 0; b < 256; b++) {
+        pixel[3 * b] = b;
+        pixel[3 * b + 1] = g;
+        pixel[3 * b + 2] = r;
+      }
+    }
+
+    cvtColor(slice, sliceHsv, CV_BGR2HSV);
+    inRange(sliceHsv, hsvMin, hsvMax, sliceBw);
+
+    for (int g = 0; g < 256; g++) {
+      const uchar * skin = sliceBw.ptr < uchar > (g);
+      for (int b = 0; b < 256; b++) {
+        int color = (r << 16) | (g << 8) | b;
+        if (skin[b]) skinLookup[color >> 3] |= (1 << (color & 7));
+      }
+    }
+
+  }
+
+  skinLookupHsvMin = hsvMin;
+  skinLookupHsvMax = hsvMax;
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::updateSkinLookup() {
+  if (flagActivateSkinColor && (skinLookup.empty() || skinLookupHsvMin != hsvMin || skinLookupHsvMax != hsvMax)) buildSkinLookup();
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::preprocessSkinColor(const cv::Mat & image, DETECTION_CONTEXT & context) const {
+
+  cv::Mat & imageGray = context.imageGray;
+  cv::Mat & integralBw = context.integralBw;
+  cv::Mat & integralBlocks = context.integralBlocks;
+
+  /*Fixed point coefficients of cvtColor(CV_BGR2GRAY) for 8 bit images, so imageGray is the same*/
+  const int shift = 14;
+  const int R2Y = 4899, G2Y = 9617, B2Y = 1868;
+
+  int rowsBlocks = (image.rows + skinBlockSize - 1) / skinBlockSize;
+  int colsBlocks = (image.cols + skinBlockSize - 1) / skinBlockSize;
+
+  integralBw.create(image.rows + 1, image.cols + 1, CV_32SC1);
+  integralBlocks = cv::Mat::zeros(rowsBlocks + 1, colsBlocks + 1, CV_32SC1);
+  std::fill(integralBw.ptr < int > (0), integralBw.ptr < int > (0) + integralBw.cols, 0);
+
+  const uchar * lookup = & skinLookup[0];
+
+  for (int i = 0; i < image.rows; i++) {
+
+    const uchar * pixel = image.ptr < uchar > (i);
+    uchar * gray = imageGray.ptr < uchar > (i);
+    const int * sumAbove = integralBw.ptr < int > (i);
+    int * sum = integralBw.ptr < int > (i + 1);
+    int * blocks = integralBlocks.ptr < int > (i / skinBlockSize + 1) + 1; // Skin of each block of the row of blocks, integrated below
+
+    int sumRow = 0;
+    sum[0] = 0;
+
+    for (int j = 0; j < image.cols; j++, pixel = pixel + 3) {
+
+      int b = pixel[0], g = pixel[1], r = pixel[2];
+      gray[j] = (uchar)((B2Y * b + G2Y * g + R2Y * r + (1 << (shift - 1))) >> shift);
+
+      int color = (r << 16) | (g << 8) | b;
+      int skin = (lookup[color >> 3] >> (color & 7)) & 1; // 1 where the mask of inRange is 255, so the integral counts pixels and does not overflow
+      sumRow = sumRow + skin;
+      sum[j + 1] = sumAbove[j + 1] + sumRow;
+      blocks[j / skinBlockSize] += skin;
+
+    }
+
+  }
+
+  /*Integral of the blocks*/
+  for (int i = 1; i <= rowsBlocks; i++) {
+    const int * above = integralBlocks.ptr < int > (i - 1);
+    int * row = integralBlocks.ptr < int > (i);
+    int sumRow = 0;
+    for (int j = 1; j <= colsBlocks; j++) {
+      sumRow = sumRow + row[j];
+      row[j] = above[j] + sumRow;
+    }
+  }
+
+}
+
+/*Skin of the blocks that cover the rows [row, row + size) and the columns [col, col + size), this is an upper bound of the skin of that region*/
+static inline int skinOfBlocks(const cv::Mat & integralBlocks, int row, int col, int rows, int cols) {
+  int r1 = row / skinBlockSize, r2 = (row + rows - 1) / skinBlockSize + 1;
+  int c1 = col / skinBlockSize, c2 = (col + cols - 1) / skinBlockSize + 1;
+  return integralBlocks.at < int > (r2, c2) + integralBlocks.at < int > (r1, c1) - (integralBlocks.at < int > (r2, c1) + integralBlocks.at < int > (r1, c2));
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::rowMayHaveSkinColor(const DETECTION_CONTEXT & context, int row, int size) const {
+  return skinOfBlocks(context.integralBlocks, row, 0, size, context.imageGray.cols) > 0.3 * size * size;
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::windowHasSkinColor(const DETECTION_CONTEXT & context, int row, int col, int size) const {
+  const cv::Mat & integralBw = context.integralBw;
+  if (skinOfBlocks(context.integralBlocks, row, col, size, size) <= 0.3 * size * size) return false; // Not even the blocks that cover the window have enough skin
+  double sum2 = integralBw.at < int > (row + size, col + size) + integralBw.at < int > (row, col) - (integralBw.at < int > (row + size, col) + integralBw.at < int > (row, col + size)); // Integral image evaluation
+  return sum2 > 0.3 * size * size; // More than 30% of the pixels of the window are skin
+}
+
+// ________________________________________________________________________________
+
+/*First p >= a such that p + origin is a multiple of step (a + origin >= 0)*/
+static inline int alignToStep(int a, int step, int origin = 0) {
+  return ((a + origin + step - 1) / step) * step - origin;
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::getColumnsOfRow(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, int topLeft_x, int & firstCol, int & lastCol) const {
+
+  firstCol = item.firstCol;
+  lastCol = item.lastCol;
+  if (context.maskColumns.empty()) return true;
+
+  const std::vector < int > & columns = context.maskColumns[item.scale];
+  if (columns[2 * topLeft_x] > columns[2 * topLeft_x + 1]) return false;
+
+  /*The grid of the scan is aligned to the origin of the item*/
+  double factorCols = double(item.widthWindow) / item.sizeBase;
+  firstCol = std::max(firstCol, alignToStep(int(std::ceil(columns[2 * topLeft_x] * factorCols)), item.stepCols, item.originCol));
+  lastCol = std::min(lastCol, int(columns[2 * topLeft_x + 1] * factorCols));
+  return firstCol <= lastCol;
+}
+
+const int * CASCADE_CLASSIFIERS_EVALUATION::getWindowOffsets(const DETECTION_CONTEXT & context, int scale, int orderDegrees) const {
+  if (flagPyramid) return & context.pyramidOffsets[2 * orderDegrees * flatCascade.getNumberSplitNodes()];
+  return & context.featureOffsets[2 * (orderDegrees * context.numberScales + scale) * flatCascade.getNumberSplitNodes()];
+}
+
+cv::Rect CASCADE_CLASSIFIERS_EVALUATION::getWindowsInside(const SCAN_WORK_ITEM & item, const cv::Rect & footprint) const {
+
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 0
+  if (flagPyramid) return cv::Rect(0, 0, item.image -> cols, item.image -> rows); // The levels of the pyramid have their own background
+  #endif
+
+  int kx = item.sizeBase / widthImages, ky = item.sizeBase / highImages;
+  int firstRow = -ky * footprint.y;
+  int lastRow = item.image -> rows - 1 - ky * (footprint.y + footprint.height - 1);
+  int firstCol = -kx * footprint.x;
+  int lastCol = item.image -> cols - 1 - kx * (footprint.x + footprint.width - 1);
+
+  return cv::Rect(firstCol, firstRow, std::max(0, lastCol - firstCol + 1), std::max(0, lastRow - firstRow + 1));
+}
+
+/*True if the top-left pixel (row, col) is in the rectangle inside*/
+static inline bool windowIsInside(const cv::Rect & inside, int row, int col) {
+  return row >= inside.y && row < inside.y + inside.height && col >= inside.x && col < inside.x + inside.width;
+}
+
+int CASCADE_CLASSIFIERS_EVALUATION::evaluateWindow(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, bool inside, int row, int col, int orderDegrees, int beginStage, int endStage, double * score) const {
+
+  if (inside) return flatCascade.evaluate(item.image -> ptr < uchar > (row) + col, getWindowOffsets(context, item.scale, orderDegrees), beginStage, endStage, score);
+
+  /*At the edges of the image some features of rotated windows are outside it, their coordinates are clamped to the borders*/
+  const short * coordinates = & featureCoordinates[4 * orderDegrees * flatCascade.getNumberSplitNodes()];
+  return flatCascade.evaluateClamped( * item.image, row, col, item.sizeBase / widthImages, item.sizeBase / highImages, coordinates, beginStage, endStage, score);
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::angleIsPromising(int stageReached, double score) const {
+  return stageReached == numberClassifiersUsed || score >= flatCascade.getStageThreshold(stageReached) - anglePruningMargin;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::evaluatePrunedAngles(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, bool inside, int row, int col, const std::vector < int > & anglesSorted, int reference, int * stageReached, double * scores) const {
+
+  for (int k = 0; k < anglesSorted.size(); k++)
+    stageReached[k] = -1;
+
+  /*The angle closest to 0 degrees is always evaluated, the others only while the angle next to them on the side of 0 degrees is promising*/
+  for (int direction = -1; direction <= 1; direction = direction + 2) {
+    for (int k = reference; k >= 0 && k < anglesSorted.size(); k = k + direction) {
+
+      int orderDegrees = anglesSorted[k];
+      if (stageReached[orderDegrees] != -1) continue; // The reference is shared by both directions
+      if (k != reference && !angleIsPromising(stageReached[anglesSorted[k - direction]], scores[anglesSorted[k - direction]])) break;
+
+      scores[orderDegrees] = 0;
+      stageReached[orderDegrees] = evaluateWindow(context, item, inside, row, col, orderDegrees, 0, numberClassifiersUsed, & scores[orderDegrees]);
+
+    }
+  }
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::scanBand(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, std::vector < WINDOW_DETECTION > & detections) const {
+
+  /*Factors that map the coordinates of item.image to the input image, both are 1 when the windows are scanned in imageGray*/
+  double factorRows = double(item.sizeBase) / item.highWindow;
+  double factorCols = double(item.sizeBase) / item.widthWindow;
+
+  /*With flagAnglePruning the angles are visited in order of their value, starting from the one closest to 0 degrees*/
+  bool pruneAngles = flagAnglePruning && degrees.size() > 1;
+  std::vector < int > anglesSorted;
+  int reference = 0;
+  std::vector < int > stageReached(degrees.size());
+  std::vector < double > scores(degrees.size());
+  if (pruneAngles) {
+    for (int k = 0; k < degrees.size(); k++) {
+      int position = anglesSorted.size();
+      while (position > 0 && degrees[anglesSorted[position - 1]] > degrees[k]) position--;
+      anglesSorted.insert(anglesSorted.begin() + position, k);
+    }
+    for (int k = 1; k < anglesSorted.size(); k++)
+      if (std::fabs(degrees[anglesSorted[k]]) < std::fabs(degrees[anglesSorted[reference]])) reference = k;
+  }
+
+  cv::Rect windowsInside = getWindowsInside(item, featureFootprint);
+
+  for (int i = item.firstRow; i <= item.lastRow; i = i + item.stepRows) {
+
+    int topLeft_x = std::min(cvRound(i * factorRows), context.imageGray.rows - item.sizeBase); // Row of the window in the input image
+    if (context.skinColor && !rowMayHaveSkinColor(context, topLeft_x, item.sizeBase)) continue; // No window of the row can pass the skin color test
+
+    int firstCol, lastCol;
+    if (!getColumnsOfRow(context, item, topLeft_x, firstCol, lastCol)) continue;
+
+    for (int j = firstCol; j <= lastCol; j = j + item.stepCols) {
+
+      int topLeft_y = std::min(cvRound(j * factorCols), context.imageGray.cols - item.sizeBase); // Column of the window in the input image
+
+      if (context.skinColor && !windowHasSkinColor(context, topLeft_x, topLeft_y, item.sizeBase)) continue;
+
+      bool inside = windowIsInside(windowsInside, i, j);
+
+      if (pruneAngles) {
+        evaluatePrunedAngles(context, item, inside, i, j, anglesSorted, reference, & stageReached[0], & scores[0]);
+        for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
+          #if defined(UVFACE_SCAN_STATISTICS)
+          if (stageReached[orderDegrees] != -1) item.statistics -> countWindow(stageReached[orderDegrees], numberClassifiersUsed);
+          #endif
+          if (stageReached[orderDegrees] == numberClassifiersUsed)
+            detections.push_back(WINDOW_DETECTION(topLeft_y, topLeft_x, item.sizeBase, orderDegrees, scores[orderDegrees]));
+        }
+        continue;
+      }
+
+      for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
+
+        double score = 0;
+        int stageReached = evaluateWindow(context, item, inside, i, j, orderDegrees, 0, numberClassifiersUsed, & score);
+        #if defined(UVFACE_SCAN_STATISTICS)
+        item.statistics -> countWindow(stageReached, numberClassifiersUsed);
+        #endif
+        if (stageReached == numberClassifiersUsed)
+          detections.push_back(WINDOW_DETECTION(topLeft_y, topLeft_x, item.sizeBase, orderDegrees, score));
+
+      }
+
+    }
+  }
+
+}
+
+/*Order of the detections in the depth-first scan of a row: by column and then by degree*/
+static bool compareDetectionsInRow(const WINDOW_DETECTION & d1, const WINDOW_DETECTION & d2) {
+  return (d1.x < d2.x) || (d1.x == d2.x && d1.orderDegrees < d2.orderDegrees);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::scanBandBreadthFirst(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, std::vector < WINDOW_DETECTION > & detections) const {
+
+  double factorRows = double(item.sizeBase) / item.highWindow;
+  double factorCols = double(item.sizeBase) / item.widthWindow;
+
+  std::vector < int > rowWindows; //Columns (in item.image) of the windows of the row that pass the skin color test and lie inside the image
+  std::vector < int > edgeWindows; //Columns of the windows of the row whose features reach the borders, they are evaluated depth-first
+  std::vector < int > windows; //Survivors of each stage
+  std::vector < double > scores;
+  std::vector < WINDOW_DETECTION > rowDetections;
+
+  cv::Rect windowsInside = getWindowsInside(item, featureFootprint);
+
+  for (int i = item.firstRow; i <= item.lastRow; i = i + item.stepRows) {
+
+    int topLeft_x = std::min(cvRound(i * factorRows), context.imageGray.rows - item.sizeBase);
+    if (context.skinColor && !rowMayHaveSkinColor(context, topLeft_x, item.sizeBase)) continue;
+
+    int firstCol, lastCol;
+    if (!getColumnsOfRow(context, item, topLeft_x, firstCol, lastCol)) continue;
+
+    rowWindows.clear();
+    edgeWindows.clear();
+    for (int j = firstCol; j <= lastCol; j = j + item.stepCols) {
+      if (context.skinColor && !windowHasSkinColor(context, topLeft_x, std::min(cvRound(j * factorCols), context.imageGray.cols - item.sizeBase), item.sizeBase)) continue;
+      if (windowIsInside(windowsInside, i, j)) rowWindows.push_back(j);
+      else edgeWindows.push_back(j);
+    }
+
+    if (rowWindows.empty() && edgeWindows.empty()) continue;
+
+    const uchar * row = item.image -> ptr < uchar > (i);
+    rowDetections.clear();
+
+    for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
+
+      for (int k = 0; k < edgeWindows.size(); k++) {
+        double score = 0;
+        int stageReached = evaluateWindow(context, item, false, i, edgeWindows[k], orderDegrees, 0, numberClassifiersUsed, & score);
+        #if defined(UVFACE_SCAN_STATISTICS)
+        item.statistics -> countWindow(stageReached, numberClassifiersUsed);
+        #endif
+        if (stageReached == numberClassifiersUsed)
+          rowDetections.push_back(WINDOW_DETECTION(edgeWindows[k], topLeft_x, item.sizeBase, orderDegrees, score));
+      }
+
+      if (rowWindows.empty()) continue;
+
+      const int * offsets = getWindowOffsets(context, item.scale, orderDegrees);
+
+      windows = rowWindows;
+      scores.resize(windows.size());
+      #if defined(UVFACE_SCAN_STATISTICS)
+      item.statistics -> windows = item.statistics -> windows + windows.size();
+      int survivors = flatCascade.evaluateBreadthFirst(row, offsets, & windows[0], & scores[0], windows.size(), numberClassifiersUsed, & item.statistics -> rejectedByStage[0]);
+      #else
+      int survivors = flatCascade.evaluateBreadthFirst(row, offsets, & windows[0], & scores[0], windows.size(), numberClassifiersUsed);
+      #endif
+
+      for (int k = 0; k < survivors; k++)
+        rowDetections.push_back(WINDOW_DETECTION(windows[k], topLeft_x, item.sizeBase, orderDegrees, scores[k]));
+
+    }
+
+    /*The detections are sorted by their column in item.image, before mapping it to the input image where two columns may round to the same one*/
+    if (degrees.size() > 1 || !edgeWindows.empty()) std::sort(rowDetections.begin(), rowDetections.end(), compareDetectionsInRow);
+    for (int k = 0; k < rowDetections.size(); k++)
+      rowDetections[k].x = std::min(cvRound(rowDetections[k].x * factorCols), context.imageGray.cols - item.sizeBase);
+    detections.insert(detections.end(), rowDetections.begin(), rowDetections.end());
+
+  }
+
+}
+
+/*Key used to remove the windows found twice when the search regions overlap*/
+static bool compareDetectionsWindow(const WINDOW_DETECTION & d1, const WINDOW_DETECTION & d2) {
+  if (d1.size != d2.size) return d1.size < d2.size;
+  if (d1.y != d2.y) return d1.y < d2.y;
+  if (d1.x != d2.x) return d1.x < d2.x;
+  if (d1.orderDegrees != d2.orderDegrees) return d1.orderDegrees < d2.orderDegrees;
+  return d1.model < d2.model;
+}
+
+/*States of the windows of the normal grid in scanBandCoarseToFine*/
+enum WINDOW_STATE {
+  WINDOW_NOT_SCANNED = 0,
+  WINDOW_REFINED = 1, //Neighbor of a coarse candidate, the whole cascade is evaluated
+  WINDOW_COARSE_PASSED = 2, //Coarse window that passed the first stages, only the remaining stages are evaluated
+  WINDOW_COARSE_REJECTED = 3 //Coarse window rejected in the first stages, it is not evaluated again
+};
+
+void CASCADE_CLASSIFIERS_EVALUATION::scanBandCoarseToFine(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, std::vector < WINDOW_DETECTION > & detections) const {
+
+  double factorRows = double(item.sizeBase) / item.highWindow;
+  double factorCols = double(item.sizeBase) / item.widthWindow;
+
+  int numberRows = (item.lastRow - item.firstRow) / item.stepRows + 1;
+  int numberCols = (item.lastCol - item.firstCol) / item.stepCols + 1;
+  int numberDegrees = degrees.size();
+  int stagesCoarse = std::min(coarseStages, numberClassifiersUsed);
+
+  std::vector < unsigned char > states(numberRows * numberCols * numberDegrees, WINDOW_NOT_SCANNED); //One of WINDOW_STATE for each window and degree of the band
+  std::vector < double > scores(states.size(), 0); //Score of the last stage evaluated in the coarse pass
+  cv::Rect windowsInside = getWindowsInside(item, featureFootprint);
+
+  //_________________Coarse pass________________//
+  /*The coarse grid is aligned to the origin of the item (the one of the normal grid), not to the band, and the coarse windows up to
+  refinementRadius steps above and below the band are also evaluated because their neighborhoods reach it, so the result does not depend on
+  how the scan is split in bands. The coarse windows are on the normal grid, so r and c below are exact*/
+  int coarseRows = coarseStep * item.stepRows;
+  int coarseCols = coarseStep * item.stepCols;
+  int lastCoarseRow = std::min(item.lastRow + refinementRadius * item.stepRows, item.image -> rows - item.highWindow);
+  int lastCoarseCol = std::min(item.lastCol + refinementRadius * item.stepCols, item.image -> cols - item.widthWindow);
+
+  for (int i = alignToStep(std::max(0, item.firstRow - refinementRadius * item.stepRows), coarseRows, item.originRow); i <= lastCoarseRow; i = i + coarseRows) {
+
+    int topLeft_x = std::min(cvRound(i * factorRows), context.imageGray.rows - item.sizeBase);
+    if (context.skinColor && !rowMayHaveSkinColor(context, topLeft_x, item.sizeBase)) continue;
+
+    int r = (i - item.firstRow) / item.stepRows;
+
+    for (int j = alignToStep(std::max(0, item.firstCol - refinementRadius * item.stepCols), coarseCols, item.originCol); j <= lastCoarseCol; j = j + coarseCols) {
+
+      if (context.skinColor && !windowHasSkinColor(context, topLeft_x, std::min(cvRound(j * factorCols), context.imageGray.cols - item.sizeBase), item.sizeBase)) continue;
+
+      int c = (j - item.firstCol) / item.stepCols;
+      bool inBand = (r >= 0 && r < numberRows && c >= 0 && c < numberCols);
+      bool inside = windowIsInside(windowsInside, i, j);
+
+      for (int orderDegrees = 0; orderDegrees < numberDegrees; orderDegrees++) {
+
+        double score = 0;
+        int stageReached = evaluateWindow(context, item, inside, i, j, orderDegrees, 0, stagesCoarse, & score);
+        bool passed = (stageReached == stagesCoarse);
+
+        #if defined(UVFACE_SCAN_STATISTICS)
+        if (inBand && !passed) item.statistics -> countWindow(stageReached, numberClassifiersUsed); // The survivors are counted in the fine pass
+        #endif
+
+        if (inBand) {
+          int k = (r * numberCols + c) * numberDegrees + orderDegrees;
+          states[k] = passed ? WINDOW_COARSE_PASSED : WINDOW_COARSE_REJECTED;
+          scores[k] = score;
+        }
+
+        if (!passed) continue;
+
+        for (int rr = std::max(0, r - refinementRadius); rr <= std::min(numberRows - 1, r + refinementRadius); rr++)
+          for (int cc = std::max(0, c - refinementRadius); cc <= std::min(numberCols - 1, c + refinementRadius); cc++) {
+            int k = (rr * numberCols + cc) * numberDegrees + orderDegrees;
+            if (states[k] == WINDOW_NOT_SCANNED) states[k] = WINDOW_REFINED;
+          }
+
+      }
+
+    }
+  }
+  //____________________________________________//
+
+  //_________________Fine pass__________________//
+  /*The candidates are visited in the order of scanBand, so the detections are a subset of the normal scan in the same order*/
+  for (int r = 0; r < numberRows; r++) {
+
+    int i = item.firstRow + r * item.stepRows;
+    int topLeft_x = std::min(cvRound(i * factorRows), context.imageGray.rows - item.sizeBase);
+
+    int firstCol, lastCol;
+    if (!getColumnsOfRow(context, item, topLeft_x, firstCol, lastCol)) continue;
+
+    for (int c = (firstCol - item.firstCol) / item.stepCols; c <= (lastCol - item.firstCol) / item.stepCols; c++) {
+
+      int j = item.firstCol + c * item.stepCols;
+      int topLeft_y = std::min(cvRound(j * factorCols), context.imageGray.cols - item.sizeBase);
+      bool inside = windowIsInside(windowsInside, i, j);
+
+      for (int orderDegrees = 0; orderDegrees < numberDegrees; orderDegrees++) {
+
+        int k = (r * numberCols + c) * numberDegrees + orderDegrees;
+        if (states[k] == WINDOW_NOT_SCANNED || states[k] == WINDOW_COARSE_REJECTED) continue;
+        if (states[k] == WINDOW_REFINED && context.skinColor && !windowHasSkinColor(context, topLeft_x, topLeft_y, item.sizeBase)) continue;
+
+        double score = scores[k];
+        int beginStage = (states[k] == WINDOW_COARSE_PASSED) ? stagesCoarse : 0;
+        int stageReached = evaluateWindow(context, item, inside, i, j, orderDegrees, beginStage, numberClassifiersUsed, & score);
+        #if defined(UVFACE_SCAN_STATISTICS)
+        item.statistics -> countWindow(stageReached, numberClassifiersUsed);
+        #endif
+        if (stageReached == numberClassifiersUsed)
+          detections.push_back(WINDOW_DETECTION(topLeft_y, topLeft_x, item.sizeBase, orderDegrees, score));
+
+      }
+
+    }
+  }
+  //____________________________________________//
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::scanBandMultiModel(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, const std::vector < SCAN_MODEL > & models, std::vector < WINDOW_DETECTION > & detections) const {
+
+  double factorRows = double(item.sizeBase) / item.highWindow;
+  double factorCols = double(item.sizeBase) / item.widthWindow;
+  int kx = item.sizeBase / widthImages, ky = item.sizeBase / highImages;
+
+  std::vector < cv::Rect > windowsInside(models.size());
+  for (int m = 0; m < models.size(); m++)
+    windowsInside[m] = getWindowsInside(item, models[m].footprint);
+
+  for (int i = item.firstRow; i <= item.lastRow; i = i + item.stepRows) {
+
+    int topLeft_x = std::min(cvRound(i * factorRows), context.imageGray.rows - item.sizeBase);
+    if (context.skinColor && !rowMayHaveSkinColor(context, topLeft_x, item.sizeBase)) continue;
+
+    int firstCol, lastCol;
+    if (!getColumnsOfRow(context, item, topLeft_x, firstCol, lastCol)) continue;
+
+    for (int j = firstCol; j <= lastCol; j = j + item.stepCols) {
+
+      int topLeft_y = std::min(cvRound(j * factorCols), context.imageGray.cols - item.sizeBase);
+      if (context.skinColor && !windowHasSkinColor(context, topLeft_x, topLeft_y, item.sizeBase)) continue;
+
+      /*The models are evaluated one after the other on the same window, so its pixels are still in the cache for the next one*/
+      for (int m = 0; m < models.size(); m++) {
+
+        bool inside = windowIsInside(windowsInside[m], i, j);
+
+        for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
+
+          double score = 0;
+          int stageReached = models[m].evaluate(item, inside, i, j, orderDegrees, kx, ky, & score);
+          #if defined(UVFACE_SCAN_STATISTICS)
+          /*The counters of the stages are those of this cascade, the windows of the other models are only counted with their trees*/
+          if (m == 0) item.statistics -> countWindow(stageReached, numberClassifiersUsed);
+          else item.statistics -> countWindowOtherModel(models[m].cascade -> getNumberTrees(0, std::min(stageReached + 1, models[m].numberStages)));
+          #endif
+          if (stageReached == models[m].numberStages)
+            detections.push_back(WINDOW_DETECTION(topLeft_y, topLeft_x, item.sizeBase, orderDegrees, score, m));
+
+        }
+
+      }
+
+    }
+  }
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::prepareModels(DETECTION_CONTEXT & context, const std::vector < const CASCADE_CLASSIFIERS_EVALUATION * > & others, std::vector < SCAN_MODEL > & models) const {
+
+  std::vector < const FLAT_CASCADE_EVALUATION * > cascades;
+  for (int k = 0; k < others.size(); k++)
+    if (hasSameWindows( * others[k])) cascades.push_back( & others[k] -> flatCascade);
+
+  /*The tables depend on the degrees and scales of this cascade and on the strides of the buffers, they are kept until these change*/
+  if (context.modelCascades != cascades || context.modelPyramid != flagPyramid) {
+
+    context.modelCascades = cascades;
+    context.modelPyramid = flagPyramid;
+    context.modelOffsets.assign(cascades.size(), std::vector < int > ());
+    context.modelCoordinates.assign(cascades.size(), std::vector < short > ());
+    context.modelFootprints.assign(cascades.size(), cv::Rect());
+
+    std::vector < int > kx, ky;
+    for (int s = 0; s < context.numberScales; s++) {
+      kx.push_back(scaleSizes[s] / widthImages);
+      ky.push_back(scaleSizes[s] / highImages);
+    }
+
+    for (int m = 0; m < cascades.size(); m++) {
+      if (flagPyramid)
+        cascades[m] -> computePyramidOffsets(degrees, widthImages, highImages, context.pyramidBackground.step, context.modelOffsets[m]);
+      else
+        cascades[m] -> computeOffsets(degrees, kx, ky, widthImages, highImages, context.imageGray.step, context.modelOffsets[m]);
+      cascades[m] -> computeCoordinates(degrees, widthImages, highImages, context.modelCoordinates[m], context.modelFootprints[m]);
+    }
+
+  }
+
+  models.clear();
+  models.push_back(SCAN_MODEL(0, & flatCascade, numberClassifiersUsed, flagPyramid ? & context.pyramidOffsets : & context.featureOffsets, flagPyramid, context.numberScales, & featureCoordinates, featureFootprint));
+  for (int k = 0, m = 0; k < others.size(); k++) {
+    if (m == cascades.size() || cascades[m] != & others[k] -> flatCascade) continue;
+    models.push_back(SCAN_MODEL(k + 1, cascades[m], others[k] -> numberClassifiersUsed, & context.modelOffsets[m], flagPyramid, context.numberScales, & context.modelCoordinates[m], context.modelFootprints[m]));
+    m++;
+  }
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::scanWindows(DETECTION_CONTEXT & context, std::vector < WINDOW_DETECTION > & detections, const std::vector < SEARCH_REGION > * searchRegions, int onlyScale, const std::vector < SCAN_MODEL > * models) const {
+
+  const cv::Mat & imageGray = context.imageGray;
+  #if defined(UVFACE_SCAN_STATISTICS)
+  double startScan = cv::getTickCount();
+  #endif
+
+  //_____________Splitting the scan in bands of rows of a single scale____________//
+  std::vector < SCAN_WORK_ITEM > items;
+  for (int idx = 0; idx < context.numberScales; idx++) {
+
+    if (onlyScale >= 0 && idx != onlyScale) continue;
+
+    int sizeBase = scaleSizes[idx];
+    const cv::Mat * image = & imageGray;
+    int widthWindow = sizeBase;
+    int highWindow = sizeBase;
+    int stepRows = sizeBase * stepWindow;
+    int stepCols = sizeBase * stepWindow;
+
+    #if DEBUG_OBJECT_GRAPH_EVALUATION == 0
+    if (flagPyramid) { // The cascade is evaluated at its native size in the level of the scale
+      image = & context.pyramidLevels[idx];
+      widthWindow = widthImages;
+      highWindow = highImages;
+      stepRows = std::max(1, int(highImages * stepWindow));
+      stepCols = std::max(1, int(widthImages * stepWindow));
+    }
+    #endif
+
+    int rowsBand = rowsPerWorkItem * stepRows;
+
+    /*Factors that map the coordinates of the input image to image*/
+    double factorRows = double(highWindow) / sizeBase;
+    double factorCols = double(widthWindow) / sizeBase;
+
+    /*Rows of the windows allowed by the scan mask, the columns are restricted in each row by the scan of the bands*/
+    int firstRowMask = 0, lastRowMask = image -> rows - highWindow;
+    if (!context.maskRows.empty()) {
+      if (context.maskRows[2 * idx] > context.maskRows[2 * idx + 1]) continue;
+      firstRowMask = alignToStep(int(std::ceil(context.maskRows[2 * idx] * factorRows)), stepRows);
+      lastRowMask = std::min(lastRowMask, int(context.maskRows[2 * idx + 1] * factorRows));
+    }
+
+    if (searchRegions == NULL) {
+      for (int i = firstRowMask; i <= lastRowMask; i = i + rowsBand)
+        items.push_back(SCAN_WORK_ITEM(idx, sizeBase, image, widthWindow, highWindow, stepRows, stepCols, i, std::min(i + rowsBand - stepRows, lastRowMask), 0, image -> cols - widthWindow));
+      continue;
+    }
+
+    for (int r = 0; r < searchRegions -> size(); r++) {
+
+      const SEARCH_REGION & searchRegion = (* searchRegions)[r];
+      if (sizeBase < searchRegion.minSizeWindow || sizeBase > searchRegion.maxSizeWindow) continue;
+
+      cv::Rect region = searchRegion.region & cv::Rect(0, 0, imageGray.cols, imageGray.rows);
+      if (region.width < sizeBase || region.height < sizeBase) continue;
+
+      /*Windows of the scan grid whose top-left corner lies in the region and that fit inside it, the first row allowed by the scan mask is
+      aligned to the same grid*/
+      int originRow = cvRound(searchRegion.origin.y * factorRows), originCol = cvRound(searchRegion.origin.x * factorCols);
+      int firstRowMaskRegion = context.maskRows.empty() ? 0 : alignToStep(int(std::ceil(context.maskRows[2 * idx] * factorRows)), stepRows, originRow);
+      int firstRow = std::max(alignToStep(int(std::ceil(region.y * factorRows)), stepRows, originRow), firstRowMaskRegion);
+      int lastRow = std::min(int((region.y + region.height - sizeBase) * factorRows), lastRowMask);
+      int firstCol = alignToStep(int(std::ceil(region.x * factorCols)), stepCols, originCol);
+      int lastCol = std::min(int((region.x + region.width - sizeBase) * factorCols), image -> cols - widthWindow);
+      if (firstCol > lastCol) continue;
+
+      for (int i = firstRow; i <= lastRow; i = i + rowsBand)
+        items.push_back(SCAN_WORK_ITEM(idx, sizeBase, image, widthWindow, highWindow, stepRows, stepCols, i, std::min(i + rowsBand - stepRows, lastRow), firstCol, lastCol, originRow, originCol));
+
+    }
+
+  }
+  //____________________________________________________________________________//
+
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 1
+  /*The object graph stores the score of each strong classifier in its own members, so it can only be evaluated by one thread and it is not
+  read-only (this mode is only for debugging)*/
+  CASCADE_CLASSIFIERS_EVALUATION * graph = const_cast < CASCADE_CLASSIFIERS_EVALUATION * > (this);
+  for (int k = 0; k < items.size(); k++) {
+
+    cv::Rect windowsInside = getWindowsInside(items[k], featureFootprint);
+    int kx = items[k].sizeBase / widthImages, ky = items[k].sizeBase / highImages;
+
+    for (int i = items[k].firstRow; i <= items[k].lastRow; i = i + items[k].stepRows) {
+      for (int j = items[k].firstCol; j <= items[k].lastCol; j = j + items[k].stepCols) {
+
+        if (context.skinColor && !windowHasSkinColor(context, i, j, items[k].sizeBase)) continue;
+        if (!context.maskColumns.empty() && (j < context.maskColumns[items[k].scale][2 * i] || j > context.maskColumns[items[k].scale][2 * i + 1])) continue;
+
+        /*The graph reads the pixels through at(), so the edge windows get a copy of their footprint with the borders replicated*/
+        cv::Mat patch, window;
+        if (windowIsInside(windowsInside, i, j)) {
+          window = cv::Mat(highImages, widthImages, CV_8UC1, const_cast < uchar * > (imageGray.ptr < uchar > (i) + j), imageGray.step);
+        } else {
+          cv::Rect area(j + kx * featureFootprint.x, i + ky * featureFootprint.y, kx * (featureFootprint.width - 1) + 1, ky * (featureFootprint.height - 1) + 1);
+          cv::Rect clipped = area & cv::Rect(0, 0, imageGray.cols, imageGray.rows);
+          cv::copyMakeBorder(imageGray(clipped), patch, clipped.y - area.y, (area.y + area.height) - (clipped.y + clipped.height), clipped.x - area.x, (area.x + area.width) - (clipped.x + clipped.width), cv::BORDER_REPLICATE);
+          window = cv::Mat(highImages, widthImages, CV_8UC1, patch.ptr < uchar > (i - area.y) + (j - area.x), patch.step);
+        }
+
+        for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
+          #if EVALUATION_FDDB == 1
+          if (graph -> FDDB_evaluateClassifier(window, items[k].scale, orderDegrees))
+            detections.push_back(WINDOW_DETECTION(j, i, items[k].sizeBase, orderDegrees, graph -> scoreDetection));
+          #else
+          if (graph -> evaluateClassifier(window, items[k].scale, orderDegrees))
+            detections.push_back(WINDOW_DETECTION(j, i, items[k].sizeBase, orderDegrees));
+          #endif
+        }
+
+      }
+    }
+  }
+  #else
+  /*Each work item has its own list of detections, they are concatenated in the order of the items so the result does not depend on the threads*/
+  std::vector < std::vector < WINDOW_DETECTION > > itemDetections(items.size());
+
+  #if defined(UVFACE_SCAN_STATISTICS)
+  /*Each work item also has its own counters, they are added to the scanStatistics of the context after the scan*/
+  std::vector < SCAN_STATISTICS > itemStatistics(items.size());
+  std::vector < double > itemSeconds(items.size(), 0);
+  for (int k = 0; k < items.size(); k++) {
+    itemStatistics[k].clear(flatCascade.getNumberStages());
+    items[k].statistics = & itemStatistics[k];
+  }
+  #endif
+
+  #pragma omp parallel for schedule(dynamic) if (flagParallelScan)
+  for (int k = 0; k < (int) items.size(); k++) {
+    #if defined(UVFACE_SCAN_STATISTICS)
+    double startItem = cv::getTickCount();
+    #endif
+    if (models != NULL)
+      scanBandMultiModel(context, items[k], * models, itemDetections[k]);
+    else if (flagCoarseToFine)
+      scanBandCoarseToFine(context, items[k], itemDetections[k]);
+    else if (evaluationEngine == EVALUATION_ENGINE_BREADTH_FIRST)
+      scanBandBreadthFirst(context, items[k], itemDetections[k]);
+    else
+      scanBand(context, items[k], itemDetections[k]);
+    #if defined(UVFACE_SCAN_STATISTICS)
+    itemSeconds[k] = (cv::getTickCount() - startItem) / cv::getTickFrequency();
+    #endif
+  }
+
+  for (int k = 0; k < itemDetections.size(); k++)
+    detections.insert(detections.end(), itemDetections[k].begin(), itemDetections[k].end());
+
+  #if defined(UVFACE_SCAN_STATISTICS)
+  /*The trees follow from the stage where each window stopped: a window rejected by stage s evaluated the trees of the stages [0, s], and the
+  windows of the coarse pass that are resumed in the fine pass are only counted there*/
+  SCAN_STATISTICS & statistics = context.scanStatistics;
+  if (statistics.windowsByScale.size() < context.numberScales) {
+    statistics.windowsByScale.resize(context.numberScales, 0);
+    statistics.secondsByScale.resize(context.numberScales, 0);
+  }
+  for (int k = 0; k < itemStatistics.size(); k++) {
+    SCAN_STATISTICS & item = itemStatistics[k];
+    for (int s = 0; s < numberClassifiersUsed; s++)
+      item.trees = item.trees + item.rejectedByStage[s] * flatCascade.getNumberTrees(0, s + 1);
+    item.trees = item.trees + item.getWindowsEntering(numberClassifiersUsed) * flatCascade.getNumberTrees(0, numberClassifiersUsed);
+    statistics.add(item);
+    statistics.windowsByScale[items[k].scale] = statistics.windowsByScale[items[k].scale] + item.windows;
+    statistics.secondsByScale[items[k].scale] = statistics.secondsByScale[items[k].scale] + itemSeconds[k];
+  }
+  #endif
+  #endif
+
+  /*The windows shared by overlapping regions were scanned once per region, only their first occurrence is kept*/
+  if (searchRegions != NULL && searchRegions -> size() > 1) {
+    std::set < WINDOW_DETECTION, bool( * )(const WINDOW_DETECTION &, const WINDOW_DETECTION &) > found(compareDetectionsWindow);
+    int n = 0;
+    for (int k = 0; k < detections.size(); k++)
+      if (found.insert(detections[k]).second) detections[n++] = detections[k];
+    detections.erase(detections.begin() + n, detections.end());
+  }
+
+  #if defined(UVFACE_SCAN_STATISTICS)
+  context.scanStatistics.scans++;
+  context.scanStatistics.secondsScan = context.scanStatistics.secondsScan + (cv::getTickCount() - startScan) / cv::getTickFrequency();
+  #endif
+
+}
+
+// __________________________________ DECLARING DIFFERENT DETECTION FUNCTIONS __________________________________
+
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesUngrouped(cv::Mat& image, const std::vector < SEARCH_REGION > * searchRegions) {
+  detectObjectRectanglesUngrouped(defaultContext, image, searchRegions);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesUngrouped(DETECTION_CONTEXT & context, cv::Mat& image, const std::vector < SEARCH_REGION > * searchRegions) const {
+
+  preprocessImage(image, context);
+
+  std::vector < WINDOW_DETECTION > detections;
+  scanWindows(context, detections, searchRegions);
+
+  /*The detections of the same window at several degrees are consecutive, they are drawn as a single window with the average degree*/
+  for (int k = 0; k < detections.size();) {
+
+    double myDegree = 0;
+    int num = 0;
+    const WINDOW_DETECTION & d = detections[k];
+    for (; k < detections.size() && detections[k].x == d.x && detections[k].y == d.y && detections[k].size == d.size; k++) {
+      myDegree = myDegree + degrees[detections[k].orderDegrees];
+      num++;
+    }
+
+    myDegree = myDegree / num;
+    cv::RotatedRect rectRotate(cv::Point2f(d.x + (d.size / 2), d.y + (d.size / 2)), cv::Size2f(d.size, d.size), -myDegree);
+    cv::Point2f vertices[4];
+    rectRotate.points(vertices);
+    for (int i = 0; i < 4; i++)
+      cv::line(image, vertices[i], vertices[(i + 1) % 4], colorRectangles, lineThicknessRectangles);
+
+  }
+
+}
+
+//________________________________________ GROUPING OF THE DETECTIONS ________________________________________//
+
+/*Position and sides of a rectangle as seen by the similarity predicates: the top-left corner of a cv::Rect and the center of a cv::RotatedRect*/
+class GRID_BOX {
+  public: GRID_BOX(double x, double y, double width, double height): x(x),
+  y(y),
+  width(width),
+  height(height) {}
+  double x;
+  double y;
+  double width;
+  double height;
+};
+
+static inline GRID_BOX gridBox(const cv::Rect & r) {
+  return GRID_BOX(r.x, r.y, r.width, r.height);
+}
+
+static inline GRID_BOX gridBox(const cv::RotatedRect & r) {
+  return GRID_BOX(r.center.x, r.center.y, r.size.width, r.size.height);
+}
+
+static int findRoot(std::vector < int > & parent, int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+/*
+Same result as cv::partition with the similarity predicates of this file (cv::SimilarRects, SimilarRectsRotated and FDDB_SimilarRects), whose
+tolerance between two rectangles of sides (w1, h1) and (w2, h2) is delta = eps * (min(w1, w2) + min(h1, h2)) / 2: similar rectangles have
+positions at most delta apart and sides at most 2 * delta apart. The rectangles are split by their sides (the scan only produces a few
+different sizes) and, for each pair of sizes that may be similar, hashed in a grid of cells of side delta + 1, so the predicate is only
+evaluated on the rectangles of the 3x3 neighboring cells instead of on all the pairs. The classes are the connected components of the
+predicate (union-find) numbered in order of their first rectangle, as cv::partition numbers them
+*/
+template < typename T, typename PREDICATE >
+static int partitionByGrid(const std::vector < T > & rects, std::vector < int > & labels, const PREDICATE & predicate, double eps) {
+
+  int n = rects.size();
+  std::vector < GRID_BOX > boxes;
+  for (int i = 0; i < n; i++)
+    boxes.push_back(gridBox(rects[i]));
+
+  //_____________Rectangles grouped by their sides____________//
+  std::vector < std::pair < std::pair < double, double > , int > > bySize(n);
+  for (int i = 0; i < n; i++)
+    bySize[i] = std::make_pair(std::make_pair(boxes[i].width, boxes[i].height), i);
+  std::sort(bySize.begin(), bySize.end());
+
+  std::vector < int > sizeBegin; // The rectangles of the size s are bySize[sizeBegin[s], sizeBegin[s + 1])
+  for (int k = 0; k < n; k++)
+    if (k == 0 || bySize[k].first != bySize[k - 1].first) sizeBegin.push_back(k);
+  sizeBegin.push_back(n);
+  int numberSizes = sizeBegin.size() - 1;
+  //_________________________________________________________//
+
+  std::vector < int > parent(n);
+  for (int i = 0; i < n; i++)
+    parent[i] = i;
+
+  std::vector < std::pair < std::pair < int, int > , int > > cells; // (cell, rectangle) of the size b, sorted by cell
+
+  for (int b = 0; b < numberSizes; b++) {
+    for (int a = 0; a <= b; a++) {
+
+      double wa = bySize[sizeBegin[a]].first.first, ha = bySize[sizeBegin[a]].first.second;
+      double wb = bySize[sizeBegin[b]].first.first, hb = bySize[sizeBegin[b]].first.second;
+      double delta = eps * (std::min(wa, wb) + std::min(ha, hb)) * 0.5;
+      if (std::abs(wa - wb) > 2 * delta + 1 || std::abs(ha - hb) > 2 * delta + 1) continue; // No rectangle of size a is similar to one of size b
+
+      double side = delta + 1;
+
+      cells.clear();
+      for (int k = sizeBegin[b]; k < sizeBegin[b + 1]; k++) {
+        const GRID_BOX & box = boxes[bySize[k].second];
+        cells.push_back(std::make_pair(std::make_pair(int(std::floor(box.x / side)), int(std::floor(box.y / side))), bySize[k].second));
+      }
+      std::sort(cells.begin(), cells.end());
+
+      for (int k = sizeBegin[a]; k < sizeBegin[a + 1]; k++) {
+
+        int i = bySize[k].second;
+        int cellX = std::floor(boxes[i].x / side);
+        int cellY = std::floor(boxes[i].y / side);
+
+        for (int dx = -1; dx <= 1; dx++)
+          for (int dy = -1; dy <= 1; dy++) {
+            std::pair < int, int > cell(cellX + dx, cellY + dy);
+            for (int m = std::lower_bound(cells.begin(), cells.end(), std::make_pair(cell, -1)) - cells.begin(); m < cells.size() && cells[m].first == cell; m++) {
+              int j = cells[m].second;
+              if (j == i || !predicate(rects[i], rects[j])) continue;
+              int rootI = findRoot(parent, i), rootJ = findRoot(parent, j);
+              if (rootI != rootJ) parent[std::max(rootI, rootJ)] = std::min(rootI, rootJ);
+            }
+          }
+
+      }
+
+    }
+  }
+
+  //_____________Numbering the classes____________//
+  std::vector < int > classOfRoot(n, -1);
+  int nclasses = 0;
+  labels.resize(n);
+  for (int i = 0; i < n; i++) {
+    int root = findRoot(parent, i);
+    if (classOfRoot[root] < 0) classOfRoot[root] = nclasses++;
+    labels[i] = classOfRoot[root];
+  }
+  //______________________________________________//
+
+  return nclasses;
+
+}
+
+// The class below is a modification of the SimilarRects class from openCV
+class SimilarRectsRotated {
+  public: SimilarRectsRotated(double _eps): eps(_eps) {}
+  inline bool operator()(const cv::RotatedRect & r1,
+    const cv::RotatedRect & r2) const {
+    double delta = eps * (std::min(r1.size.width, r2.size.width) + std::min(r1.size.height, r2.size.height)) * 0.5;
+
+    return std::abs(r1.center.x - r2.center.x) <= delta &&
+      std::abs(r1.center.y - r2.center.y) <= delta &&
+      std::abs(r1.size.width - r2.size.width) <= delta &&
+      std::abs(r1.size.height - r2.size.height) <= delta;
+  }
+  double eps;
+};
+
+/*Side of the smallest window of the groups of rects (partitioned with predicate) that survive groupThreshold, each window counting multiplicity
+times, or 0 if no group survives. These are the groups that groupRectanglesZeroDegrees and groupRectanglesRotated keep before removing those
+inside larger ones*/
+template < typename T, typename PREDICATE >
+static double smallestSideOfGroups(const std::vector < T > & rects, const std::vector < double > & sides, const PREDICATE & predicate, double eps, int groupThreshold, int multiplicity) {
+
+  std::vector < int > labels;
+  int nclasses = partitionByGrid(rects, labels, predicate, eps);
+
+  std::vector < int > weights(nclasses, 0);
+  for (int i = 0; i < labels.size(); i++)
+    weights[labels[i]] += multiplicity;
+
+  double smallestSide = 0;
+  for (int i = 0; i < labels.size(); i++)
+    if (weights[labels[i]] > groupThreshold && (smallestSide == 0 || sides[i] < smallestSide)) smallestSide = sides[i];
+
+  return smallestSide;
+}
+
+/*The same as cv::groupRectangles(rectList, groupThreshold, eps) on a list where each rectangle appears multiplicity times, without copying it.
+groupThreshold keeps the meaning of cv::groupRectangles and not that of a minimum number of neighbors: a group is kept if its weight (its
+rectangles times multiplicity) is greater than groupThreshold, so with multiplicity 2 (doubleDetectedList) and groupThreshold 1 a single
+rectangle is kept, and groupThreshold 0 or less returns the rectangles without grouping them*/
+static void groupRectanglesZeroDegrees(std::vector < cv::Rect > & rectList, int groupThreshold, double eps, int multiplicity = 1) {
+  if (groupThreshold <= 0 || rectList.empty()) {
+    return;
+  }
+
+  std::vector < int > labels;
+  int nclasses = partitionByGrid(rectList, labels, cv::SimilarRects(eps), eps);
+
+  std::vector < cv::Rect > rrects(nclasses);
+  std::vector < int > rweights(nclasses, 0);
+  int i, j, nlabels = (int) labels.size();
+  for (i = 0; i < nlabels; i++) {
+    int cls = labels[i];
+    rrects[cls].x += multiplicity * rectList[i].x;
+    rrects[cls].y += multiplicity * rectList[i].y;
+    rrects[cls].width += multiplicity * rectList[i].width;
+    rrects[cls].height += multiplicity * rectList[i].height;
+    rweights[cls] += multiplicity;
+  }
+
+  for (i = 0; i < nclasses; i++) {
+    cv::Rect r = rrects[i];
+    float s = 1.f / rweights[i];
+    rrects[i] = cv::Rect(cv::saturate_cast < int > (r.x * s),
+      cv::saturate_cast < int > (r.y * s),
+      cv::saturate_cast < int > (r.width * s),
+      cv::saturate_cast < int > (r.height * s));
+  }
+
+  rectList.clear();
+
+  for (i = 0; i < nclasses; i++) {
+    cv::Rect r1 = rrects[i];
+    int n1 = rweights[i];
+    // filter out rectangles which don't have enough similar rectangles
+    if (n1 <= groupThreshold)
+      continue;
+    // filter out small face rectangles inside large rectangles
+    for (j = 0; j < nclasses; j++) {
+      int n2 = rweights[j];
+
+      if (j == i || n2 <= groupThreshold)
+        continue;
+      cv::Rect r2 = rrects[j];
+
+      int dx = cv::saturate_cast < int > (r2.width * eps);
+      int dy = cv::saturate_cast < int > (r2.height * eps);
+
+      if (i != j &&
+        r1.x >= r2.x - dx &&
+        r1.y >= r2.y - dy &&
+        r1.x + r1.width <= r2.x + r2.width + dx &&
+        r1.y + r1.height <= r2.y + r2.height + dy &&
+        (n2 > std::max(3, n1) || n1 < 3))
+        break;
+    }
+
+    if (j == nclasses) {
+      rectList.push_back(r1);
     }
-    //_____________________________________________________________________________________________________________________//
   }
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::scanWindowsLargestFirst(DETECTION_CONTEXT & context, std::vector < WINDOW_DETECTION > & detections, const std::vector < SEARCH_REGION > * searchRegions, int multiplicity, bool rotated) const {
+
+  std::vector < cv::Rect > windows;
+  std::vector < cv::RotatedRect > windowsRotated;
+  std::vector < double > sides;
+  double smallestSide = 0; // Side of the smallest window of the groups found so far, 0 while there is none
+
+  for (int idx = context.numberScales - 1; idx >= 0; idx--) {
+
+    int sizeBase = scaleSizes[idx];
+    if (sizeBase > maxSizeObject) continue;
+    if (sizeBase < minSizeObject) break;
+
+    /*Two similar rectangles differ in their sides by at most 2 * eps times the smallest one (see cv::SimilarRects and SimilarRectsRotated). The
+    windows of this scale and of the smaller ones are not similar to any window of the groups found, so they cannot change those groups (the
+    partition is transitive, a group may grow through its smallest members) and form groups of smaller objects. The detections that do not
+    form a group yet are ignored: one of them larger than smallestSide might still form a larger group with the smaller windows, which is
+    unlikely since the sides of its group would differ by more than the tolerance*/
+    if (smallestSide > 0 && sizeBase * (1 + 2 * eps) < smallestSide) break;
+
+    int numberDetections = detections.size();
+    scanWindows(context, detections, searchRegions, idx);
+    if (detections.size() == numberDetections) continue;
+
+    /*The groups with the predicate of the grouping of the caller*/
+    for (int k = numberDetections; k < detections.size(); k++) {
+      const WINDOW_DETECTION & d = detections[k];
+      if (rotated)
+        windowsRotated.push_back(cv::RotatedRect(cv::Point2f(d.x + (d.size / 2), d.y + (d.size / 2)), cv::Size2f(d.size, d.size), -degrees[d.orderDegrees]));
+      else
+        windows.push_back(cv::Rect(d.x, d.y, d.size, d.size));
+      sides.push_back(d.size);
+    }
+    if (groupThreshold <= 0)
+      smallestSide = sizeBase; // Every detection is kept (see groupRectanglesZeroDegrees)
+    else if (rotated)
+      smallestSide = smallestSideOfGroups(windowsRotated, sides, SimilarRectsRotated(eps), eps, groupThreshold, multiplicity);
+    else
+      smallestSide = smallestSideOfGroups(windows, sides, cv::SimilarRects(eps), eps, groupThreshold, multiplicity);
 
-  if (doubleDetectedList == true) {
-    /* This is done because the cv::groupRectangles function will remove the group that contains only one rectangle, so we double the list to avoid these being removed, as they may be sparse when the false negative rate is very low */
-    //________________________________________________________________//
-    int sz = windowsCandidates.size();
-    for (int i = 0; i < sz; i++)
-      windowsCandidates.push_back(cv::Rect(windowsCandidates[i]));
-    //________________________________________________________________//
   }
 
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesGroupedZeroDegrees(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects, std::vector < cv::Rect > * coordinatesDetectedObjects, bool doubleDetectedList, bool paintDetections, const std::vector < SEARCH_REGION > * searchRegions) {
+  detectObjectRectanglesGroupedZeroDegrees(defaultContext, image, listDetectedObjects, coordinatesDetectedObjects, doubleDetectedList, paintDetections, searchRegions);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesGroupedZeroDegrees(DETECTION_CONTEXT & context, cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects, std::vector < cv::Rect > * coordinatesDetectedObjects, bool doubleDetectedList, bool paintDetections, const std::vector < SEARCH_REGION > * searchRegions) const {
+
+  std::vector < cv::Rect > & windowsCandidates = context.windowsCandidates;
+
+  preprocessImage(image, context);
+
+  std::vector < WINDOW_DETECTION > detections;
+  if (flagLargestObject)
+    scanWindowsLargestFirst(context, detections, searchRegions, doubleDetectedList ? 2 : 1, false);
+  else
+    scanWindows(context, detections, searchRegions);
+
+  for (int k = 0; k < detections.size(); k++)
+    windowsCandidates.push_back(cv::Rect(detections[k].x, detections[k].y, detections[k].size, detections[k].size));
+
   // Grouping similar rectangles
-  cv::groupRectangles(windowsCandidates, groupThreshold, eps);
+  /* With doubleDetectedList each rectangle counts twice, because cv::groupRectangles removes the groups that contain only one rectangle and they may be sparse when the false negative rate is very low. This gives the same groups as doubling the list */
+  #if defined(UVFACE_SCAN_STATISTICS)
+  double startGrouping = cv::getTickCount();
+  #endif
+  groupRectanglesZeroDegrees(windowsCandidates, groupThreshold, eps, doubleDetectedList ? 2 : 1);
+  #if defined(UVFACE_SCAN_STATISTICS)
+  context.scanStatistics.secondsGrouping = context.scanStatistics.secondsGrouping + (cv::getTickCount() - startGrouping) / cv::getTickFrequency();
+  #endif
+
+  if (flagLargestObject && windowsCandidates.size() > 1) {
+    int largest = 0;
+    for (int i = 1; i < windowsCandidates.size(); i++)
+      if (windowsCandidates[i].area() > windowsCandidates[largest].area()) largest = i;
+    windowsCandidates[0] = windowsCandidates[largest];
+    windowsCandidates.resize(1);
+  }
 
   /* NOTE: We extract the rectangles first because if we do it after drawing the rectangles, the extracted image will also be colored with the rectangle lines */
   //_________ Here we extract the detected images _________________
@@ -810,7 +3059,7 @@ void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesGroupedZeroDegrees(cv
     } else {
 
       for (int i = 0; i < windowsCandidates.size(); i++)
-        listDetectedObjects->push_back(imageGray(windowsCandidates[i]).clone());
+        listDetectedObjects->push_back(context.imageGray(windowsCandidates[i]).clone());
 
     }
 
@@ -830,22 +3079,268 @@ void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesGroupedZeroDegrees(cv
 
 }
 
-//______________________________________________________________________________________________________________//
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesMultiModel(cv::Mat & image, const std::vector < const CASCADE_CLASSIFIERS_EVALUATION * > & others, std::vector < cv::Rect > & rectangles, std::vector < int > & modelIds, bool doubleDetectedList, bool paintDetections, const std::vector < SEARCH_REGION > * searchRegions) {
+  detectObjectRectanglesMultiModel(defaultContext, image, others, rectangles, modelIds, doubleDetectedList, paintDetections, searchRegions);
+}
 
-// The class below is a modification of the SimilarRects class from openCV
-class SimilarRectsRotated {
-  public: SimilarRectsRotated(double _eps): eps(_eps) {}
-  inline bool operator()(const cv::RotatedRect & r1,
-    const cv::RotatedRect & r2) const {
-    double delta = eps * (std::min(r1.size.width, r2.size.width) + std::min(r1.size.height, r2.size.height)) * 0.5;
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesMultiModel(DETECTION_CONTEXT & context, cv::Mat & image, const std::vector < const CASCADE_CLASSIFIERS_EVALUATION * > & others, std::vector < cv::Rect > & rectangles, std::vector < int > & modelIds, bool doubleDetectedList, bool paintDetections, const std::vector < SEARCH_REGION > * searchRegions) const {
 
-    return std::abs(r1.center.x - r2.center.x) <= delta &&
-      std::abs(r1.center.y - r2.center.y) <= delta &&
-      std::abs(r1.size.width - r2.size.width) <= delta &&
-      std::abs(r1.size.height - r2.size.height) <= delta;
+  rectangles.clear();
+  modelIds.clear();
+
+  /*The grayscale image, the skin color integral and the scan mask are computed once for all the models*/
+  preprocessImage(image, context);
+
+  std::vector < SCAN_MODEL > models;
+  prepareModels(context, others, models);
+
+  std::vector < WINDOW_DETECTION > detections;
+  scanWindows(context, detections, searchRegions, -1, & models);
+
+  /*The detections are tagged with their model, so the rectangles of different models are never grouped together*/
+  std::vector < std::vector < cv::Rect > > candidates(models.size());
+  for (int k = 0; k < detections.size(); k++)
+    candidates[detections[k].model].push_back(cv::Rect(detections[k].x, detections[k].y, detections[k].size, detections[k].size));
+
+  #if defined(UVFACE_SCAN_STATISTICS)
+  double startGrouping = cv::getTickCount();
+  #endif
+  for (int m = 0; m < models.size(); m++) {
+    groupRectanglesZeroDegrees(candidates[m], groupThreshold, eps, doubleDetectedList ? 2 : 1);
+    rectangles.insert(rectangles.end(), candidates[m].begin(), candidates[m].end());
+    modelIds.insert(modelIds.end(), candidates[m].size(), models[m].id);
   }
-  double eps;
-};
+  #if defined(UVFACE_SCAN_STATISTICS)
+  context.scanStatistics.secondsGrouping = context.scanStatistics.secondsGrouping + (cv::getTickCount() - startGrouping) / cv::getTickFrequency();
+  #endif
+
+  if (paintDetections) {
+    for (int i = 0; i < rectangles.size(); i++)
+      cv::rectangle(image, rectangles[i], colorRectangles, lineThicknessRectangles);
+  }
+
+}
+
+/*The scan mask of the tile of an image of size imageSize: its pixels are those that the mask resized to the image (as computeScanMask does)
+has in the tile, without resizing the mask to the whole image, and the size limits at the first and the last row of the tile are those of
+the same rows of the image, because they are linear in the row*/
+static SCAN_MASK scanMaskOfTile(const SCAN_MASK & scanMask, const cv::Size & imageSize, const cv::Rect & tile) {
+
+  SCAN_MASK tileMask = scanMask;
+
+  double top = double(tile.y) / std::max(1, imageSize.height - 1);
+  double bottom = double(tile.y + tile.height - 1) / std::max(1, imageSize.height - 1);
+  tileMask.minSizeTop = scanMask.minSizeTop + (scanMask.minSizeBottom - scanMask.minSizeTop) * top;
+  tileMask.minSizeBottom = scanMask.minSizeTop + (scanMask.minSizeBottom - scanMask.minSizeTop) * bottom;
+  tileMask.maxSizeTop = scanMask.maxSizeTop + (scanMask.maxSizeBottom - scanMask.maxSizeTop) * top;
+  tileMask.maxSizeBottom = scanMask.maxSizeTop + (scanMask.maxSizeBottom - scanMask.maxSizeTop) * bottom;
+
+  if (!scanMask.mask.empty()) {
+    const cv::Mat & mask = scanMask.mask;
+    std::vector < int > columns(tile.width);
+    for (int c = 0; c < tile.width; c++)
+      columns[c] = std::min(mask.cols - 1, int(double(tile.x + c) * mask.cols / imageSize.width));
+    tileMask.mask.create(tile.height, tile.width, CV_8UC1);
+    for (int r = 0; r < tile.height; r++) {
+      const uchar * row = mask.ptr < uchar > (std::min(mask.rows - 1, int(double(tile.y + r) * mask.rows / imageSize.height)));
+      uchar * tileRow = tileMask.mask.ptr < uchar > (r);
+      for (int c = 0; c < tile.width; c++)
+        tileRow[c] = row[columns[c]];
+    }
+  }
+
+  return tileMask;
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesTiled(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects, std::vector < cv::Rect > * coordinatesDetectedObjects, bool doubleDetectedList, bool paintDetections) {
+  detectObjectRectanglesTiled(defaultContext, image, listDetectedObjects, coordinatesDetectedObjects, doubleDetectedList, paintDetections);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesTiled(DETECTION_CONTEXT & context, cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects, std::vector < cv::Rect > * coordinatesDetectedObjects, bool doubleDetectedList, bool paintDetections) const {
+
+  if (image.cols <= sizeTile && image.rows <= sizeTile) {
+    detectObjectRectanglesGroupedZeroDegrees(context, image, listDetectedObjects, coordinatesDetectedObjects, doubleDetectedList, paintDetections);
+    return;
+  }
+
+  /*A window whose side is at most overlap and whose top-left corner is in the first stepTile x stepTile pixels of a tile is inside that tile*/
+  int overlap = sizeTile / 4;
+  int stepTile = sizeTile - overlap;
+
+  std::vector < cv::Rect > tiles;
+  for (int y = 0; y < image.rows; y = y + stepTile)
+    for (int x = 0; x < image.cols; x = x + stepTile)
+      tiles.push_back(cv::Rect(x, y, std::min(sizeTile, image.cols - x), std::min(sizeTile, image.rows - y)));
+
+  std::vector < std::vector < WINDOW_DETECTION > > tileDetections(tiles.size());
+
+  /*Each tile has its own context, so the buffers of a thread are those of a single tile. The scan of a tile runs in the thread of the tile*/
+  #pragma omp parallel for schedule(dynamic) if (flagParallelScan && tiles.size() > 1)
+  for (int t = 0; t < (int) tiles.size(); t++) {
+
+    DETECTION_CONTEXT tileContext;
+    if (!context.scanMask.isEmpty()) tileContext.setScanMask(scanMaskOfTile(context.scanMask, image.size(), tiles[t]));
+    preprocessImage(image(tiles[t]), tileContext);
+
+    /*One region per scale: the windows of side s whose top-left corner belongs to the tile (is in [0, stepTile)) fit in its first
+    stepTile - 1 + s pixels. The origin keeps the windows on the grid of the whole image, so the tiles scan the same windows as a single scan*/
+    std::vector < SEARCH_REGION > regions;
+    for (int s = 0; s < tileContext.numberScales && scaleSizes[s] <= overlap; s++)
+      regions.push_back(SEARCH_REGION(cv::Rect(0, 0, stepTile - 1 + scaleSizes[s], stepTile - 1 + scaleSizes[s]), scaleSizes[s], scaleSizes[s], tiles[t].tl()));
+    if (!regions.empty()) scanWindows(tileContext, tileDetections[t], & regions);
+
+    for (int k = 0; k < tileDetections[t].size(); k++) {
+      tileDetections[t][k].x = tileDetections[t][k].x + tiles[t].x;
+      tileDetections[t][k].y = tileDetections[t][k].y + tiles[t].y;
+    }
+
+    #if defined(UVFACE_SCAN_STATISTICS)
+    #pragma omp critical
+    context.scanStatistics.add(tileContext.scanStatistics);
+    #endif
+
+  }
+
+  std::vector < cv::Rect > & windowsCandidates = context.windowsCandidates;
+  for (int t = 0; t < tileDetections.size(); t++)
+    for (int k = 0; k < tileDetections[t].size(); k++)
+      windowsCandidates.push_back(cv::Rect(tileDetections[t][k].x, tileDetections[t][k].y, tileDetections[t][k].size, tileDetections[t][k].size));
+
+  //______The windows larger than the overlap, in a copy of the image reduced to the size of a tile______//
+  if (!scaleSizes.empty() && scaleSizes.back() > overlap) {
+
+    double factor = double(std::max(image.cols, image.rows)) / sizeTile;
+    cv::Mat reduced;
+    cv::resize(image, reduced, cv::Size(cvRound(image.cols / factor), cvRound(image.rows / factor)), 0, 0, cv::INTER_AREA);
+
+    /*The mask is resized to the reduced copy by computeScanMask, the size limits are in pixels of the image and are reduced here. The mask
+    of the caller is given back afterwards, so the next image of the context has the limits of the image*/
+    SCAN_MASK scanMask = context.scanMask;
+    if (!scanMask.isEmpty()) {
+      SCAN_MASK reducedMask = scanMask;
+      reducedMask.minSizeTop = scanMask.minSizeTop / factor;
+      reducedMask.minSizeBottom = scanMask.minSizeBottom / factor;
+      reducedMask.maxSizeTop = scanMask.maxSizeTop / factor;
+      reducedMask.maxSizeBottom = scanMask.maxSizeBottom / factor;
+      context.setScanMask(reducedMask);
+    }
+
+    preprocessImage(reduced, context);
+    std::vector < SEARCH_REGION > regions(1, SEARCH_REGION(cv::Rect(0, 0, reduced.cols, reduced.rows), int(overlap / factor) + 1, int(sizeMaxWindow / factor)));
+    std::vector < WINDOW_DETECTION > detections;
+    scanWindows(context, detections, & regions);
+
+    if (!scanMask.isEmpty()) context.setScanMask(scanMask);
+
+    for (int k = 0; k < detections.size(); k++) {
+      int size = cvRound(detections[k].size * factor);
+      windowsCandidates.push_back(cv::Rect(cvRound(detections[k].x * factor), cvRound(detections[k].y * factor), std::min(size, image.cols), std::min(size, image.rows)));
+    }
+
+  }
+  //_________________________________________________________________________________________________________//
+
+  #if defined(UVFACE_SCAN_STATISTICS)
+  double startGrouping = cv::getTickCount();
+  #endif
+  groupRectanglesZeroDegrees(windowsCandidates, groupThreshold, eps, doubleDetectedList ? 2 : 1);
+  #if defined(UVFACE_SCAN_STATISTICS)
+  context.scanStatistics.secondsGrouping = context.scanStatistics.secondsGrouping + (cv::getTickCount() - startGrouping) / cv::getTickFrequency();
+  #endif
+
+  /*There is no grayscale copy of the whole image, the gray objects are converted one by one*/
+  if (listDetectedObjects != NULL) {
+    for (int i = 0; i < windowsCandidates.size(); i++) {
+      cv::Rect window = windowsCandidates[i] & cv::Rect(0, 0, image.cols, image.rows);
+      if (flagExtractColorImages) {
+        listDetectedObjects->push_back(image(window).clone());
+      } else {
+        cv::Mat object;
+        cvtColor(image(window), object, CV_BGR2GRAY);
+        listDetectedObjects->push_back(object);
+      }
+    }
+  }
+
+  if (paintDetections) {
+    for (int i = 0; i < windowsCandidates.size(); i++)
+      cv::rectangle(image, windowsCandidates[i], colorRectangles, lineThicknessRectangles);
+  }
+
+  if (coordinatesDetectedObjects != NULL)
+    (*coordinatesDetectedObjects) = windowsCandidates;
+
+  windowsCandidates.clear();
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesLuma(const uchar * luma, int width, int height, size_t stride, bool mirrored, std::vector < cv::Rect > & rectangles, bool doubleDetectedList, const std::vector < SEARCH_REGION > * searchRegions) {
+  detectObjectRectanglesLuma(defaultContext, luma, width, height, stride, mirrored, rectangles, doubleDetectedList, searchRegions);
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesLuma(DETECTION_CONTEXT & context, const uchar * luma, int width, int height, size_t stride, bool mirrored, std::vector < cv::Rect > & rectangles, bool doubleDetectedList, const std::vector < SEARCH_REGION > * searchRegions) const {
+
+  preprocessLuma(cv::Mat(height, width, CV_8UC1, const_cast < uchar * > (luma), stride), context);
+
+  /*The regions are given in the flipped frame, they are scanned in the plane*/
+  std::vector < SEARCH_REGION > regionsPlane;
+  if (mirrored && searchRegions != NULL) {
+    regionsPlane = * searchRegions;
+    for (int r = 0; r < regionsPlane.size(); r++)
+      regionsPlane[r].region.x = width - regionsPlane[r].region.x - regionsPlane[r].region.width;
+    searchRegions = & regionsPlane;
+  }
+
+  std::vector < WINDOW_DETECTION > detections;
+  if (flagLargestObject)
+    scanWindowsLargestFirst(context, detections, searchRegions, doubleDetectedList ? 2 : 1, false);
+  else
+    scanWindows(context, detections, searchRegions);
+
+  rectangles.clear();
+  for (int k = 0; k < detections.size(); k++)
+    rectangles.push_back(cv::Rect(mirrored ? width - detections[k].x - detections[k].size : detections[k].x, detections[k].y, detections[k].size, detections[k].size));
+
+  #if defined(UVFACE_SCAN_STATISTICS)
+  double startGrouping = cv::getTickCount();
+  #endif
+  groupRectanglesZeroDegrees(rectangles, groupThreshold, eps, doubleDetectedList ? 2 : 1);
+  #if defined(UVFACE_SCAN_STATISTICS)
+  context.scanStatistics.secondsGrouping = context.scanStatistics.secondsGrouping + (cv::getTickCount() - startGrouping) / cv::getTickFrequency();
+  #endif
+
+  if (flagLargestObject && rectangles.size() > 1) {
+    int largest = 0;
+    for (int i = 1; i < rectangles.size(); i++)
+      if (rectangles[i].area() > rectangles[largest].area()) largest = i;
+    rectangles[0] = rectangles[largest];
+    rectangles.resize(1);
+  }
+
+}
+
+void CASCADE_CLASSIFIERS_EVALUATION::extractDetectedObjects(const cv::Mat & frame, const std::vector < cv::Rect > & rectangles, bool mirrored, std::vector < cv::Mat > & objects) const {
+
+  objects.clear();
+  for (int i = 0; i < rectangles.size(); i++) {
+
+    cv::Rect window = rectangles[i];
+    if (mirrored) window.x = frame.cols - window.x - window.width;
+    window = window & cv::Rect(0, 0, frame.cols, frame.rows);
+
+    cv::Mat object;
+    if (frame.channels() == 3 && !flagExtractColorImages)
+      cvtColor(frame(window), object, CV_BGR2GRAY);
+    else
+      frame(window).copyTo(object);
+    if (mirrored) cv::flip(object, object, 1);
+    objects.push_back(object);
+
+  }
+
+}
+
+//______________________________________________________________________________________________________________//
 
 // The following function is a modification of the groupRectangle function from openCV
 void groupRectanglesRotated(std::vector < cv::RotatedRect > & rectList, int groupThreshold, double eps) {
@@ -854,7 +3349,7 @@ void groupRectanglesRotated(std::vector < cv::RotatedRect > & rectList, int grou
   }
 
   std::vector < int > labels;
-  int nclasses = partition(rectList, labels, SimilarRectsRotated(eps));
+  int nclasses = partitionByGrid(rectList, labels, SimilarRectsRotated(eps), eps);
 
   std::vector < cv::RotatedRect > rrects(nclasses);
   std::vector < int > rweights(nclasses, 0);
@@ -909,145 +3404,80 @@ void groupRectanglesRotated(std::vector < cv::RotatedRect > & rectList, int grou
   }
 }
 
-void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesRotatedGrouped(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects, std::vector < cv::RotatedRect > * coordinatesDetectedObjects, bool paintDetections) {
-
-  if (szImg != image.size()) {
-    ImageBackground = cv::Mat::zeros(sizeMaxWindow + 2 * zsBackground, sizeMaxWindow + 2 * zsBackground, CV_8UC1);
-    imageGray = ImageBackground(cv::Range(zsBackground, zsBackground + image.rows), cv::Range(zsBackground, zsBackground + image.cols));
-
-    imageAndBackgroundColor = cv::Mat::zeros(3 * image.rows, 3 * image.cols, CV_8UC3);
-    imageAndBackgroundGray = cv::Mat::zeros(3 * image.rows, 3 * image.cols, CV_8UC1);
-
-    szImg = image.size();
-  }
-
-  cvtColor(image, imageGray, CV_BGR2GRAY); // Converting to grayscale
-
-  if (flagActivateSkinColor) {
-    cvtColor(image, hsv, CV_BGR2HSV);
-    inRange(hsv, hsvMin, hsvMax, bw);
-    integral(bw, integralBw, CV_32S);
-  }
-
-  int idx = 0;
-
-  if (flagActivateSkinColor) {
-
-    //__________________________________________________________________________________________________________________________//
-    for (int sizeBase = sizeBaseEvaluation; sizeBase <= std::min(image.rows, image.cols); sizeBase = factorScaleWindow * sizeBase, idx++) {
-      int step_x = sizeBase * stepWindow; /* In this factor, the search window will move along rows */
-      int step_y = sizeBase * stepWindow; /* In this factor, the search window will move along columns */
-      for (int i = 0; i <= image.rows - sizeBase; i = i + step_x) {
-        for (int j = 0; j <= image.cols - sizeBase; j = j + step_y) {
-
-          /*__________CALCULATING WINDOW POSITION______________*/
-          int topLeft_x = i;
-          int topLeft_y = j;
-          int bottomRight_x = sizeBase + i - 1;
-          int bottomRight_y = sizeBase + j - 1;
-          /*____________________________________________________________*/
+void CASCADE_CLASSIFIERS_EVALUATION::extractRotatedObject(const cv::Mat & source, const cv::RotatedRect & window, cv::Mat & object) const {
 
-          cv::Mat window;
-          window = imageGray(cv::Range(topLeft_x, bottomRight_x + 1), cv::Range(topLeft_y, bottomRight_y + 1));
+  cv::Size sizeObject = sizeExtractedObjects;
+  if (sizeObject.width <= 0 || sizeObject.height <= 0)
+    sizeObject = cv::Size(cvRound(window.size.width), cvRound(window.size.height));
 
-          //______________________________________________________________________________//
-          double sum2 = integralBw.at < int > (bottomRight_x + 1, bottomRight_y + 1) + integralBw.at < int > (topLeft_x, topLeft_y) - (integralBw.at < int > (bottomRight_x + 1, topLeft_y) + integralBw.at < int > (topLeft_x, bottomRight_y + 1)); // Integral image evaluation
+  /*Transform from source to object: the window is rotated by its angle about its center (as cv::getRotationMatrix2D does) and scaled to
+  sizeObject, in coordinates where the pixel k covers [k, k + 1) so the center of the window goes to the center of object*/
+  double alpha = std::cos(window.angle * (M_PI / 180));
+  double beta = std::sin(window.angle * (M_PI / 180));
+  double sx = sizeObject.width / window.size.width;
+  double sy = sizeObject.height / window.size.height;
+  double cx = 0.5 - window.center.x;
+  double cy = 0.5 - window.center.y;
 
-          if (sum2 > 76.5 * sizeBase * sizeBase) { // 76.5=255*0.3
+  cv::Mat M(2, 3, CV_64FC1);
+  M.at < double > (0, 0) = sx * alpha;
+  M.at < double > (0, 1) = sx * beta;
+  M.at < double > (0, 2) = sx * (alpha * cx + beta * cy) + 0.5 * sizeObject.width - 0.5;
+  M.at < double > (1, 0) = -sy * beta;
+  M.at < double > (1, 1) = sy * alpha;
+  M.at < double > (1, 2) = sy * (-beta * cx + alpha * cy) + 0.5 * sizeObject.height - 0.5;
 
-            for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
-              if (evaluateClassifier(window, idx, orderDegrees)) {
+  cv::warpAffine(source, object, M, sizeObject, cv::INTER_CUBIC, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
 
-                cv::RotatedRect windowTemp(cv::Point2f(j + (sizeBase / 2), i + (sizeBase / 2)), cv::Size2f(sizeBase, sizeBase), -degrees[orderDegrees]);
-                windowsCandidatesRotated.push_back(windowTemp);
-
-              }
-            }
-
-          }
-          //______________________________________________________________________________//
+}
 
-        }
-      }
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesRotatedGrouped(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects, std::vector < cv::RotatedRect > * coordinatesDetectedObjects, bool paintDetections, const std::vector < SEARCH_REGION > * searchRegions) {
+  detectObjectRectanglesRotatedGrouped(defaultContext, image, listDetectedObjects, coordinatesDetectedObjects, paintDetections, searchRegions);
+}
 
-    }
-    //_____________________________________________________________________________________________________________________//
+void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesRotatedGrouped(DETECTION_CONTEXT & context, cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects, std::vector < cv::RotatedRect > * coordinatesDetectedObjects, bool paintDetections, const std::vector < SEARCH_REGION > * searchRegions) const {
 
-  } else {
-    //__________________________________________________________________________________________________________________________//
-    for (int sizeBase = sizeBaseEvaluation; sizeBase <= std::min(image.rows, image.cols); sizeBase = factorScaleWindow * sizeBase, idx++) {
-      int step_x = sizeBase * stepWindow; /* In this factor, the search window will move along rows */
-      int step_y = sizeBase * stepWindow; /* In this factor, the search window will move along columns */
-      for (int i = 0; i <= image.rows - sizeBase; i = i + step_x) {
-        for (int j = 0; j <= image.cols - sizeBase; j = j + step_y) {
-
-          /*__________CALCULATING WINDOW POSITION______________*/
-          int topLeft_x = i;
-          int topLeft_y = j;
-          int bottomRight_x = sizeBase + i - 1;
-          int bottomRight_y = sizeBase + j - 1;
-          /*____________________________________________________________*/
-
-          cv::Mat window;
-          window = imageGray(cv::Range(topLeft_x, bottomRight_x + 1), cv::Range(topLeft_y, bottomRight_y + 1));
-
-          //______________________________________________________________________________//
-          for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
-            if (evaluateClassifier(window, idx, orderDegrees)) {
-
-              cv::RotatedRect windowTemp(cv::Point2f(j + (sizeBase / 2), i + (sizeBase / 2)), cv::Size2f(sizeBase, sizeBase), -degrees[orderDegrees]);
-              windowsCandidatesRotated.push_back(windowTemp);
+  std::vector < cv::RotatedRect > & windowsCandidatesRotated = context.windowsCandidatesRotated;
 
-            }
-          }
-          //______________________________________________________________________________//
+  preprocessImage(image, context);
 
-        }
-      }
+  std::vector < WINDOW_DETECTION > detections;
+  if (flagLargestObject)
+    scanWindowsLargestFirst(context, detections, searchRegions, 1, true);
+  else
+    scanWindows(context, detections, searchRegions);
 
-    }
-    //_____________________________________________________________________________________________________________________//
+  for (int k = 0; k < detections.size(); k++) {
+    const WINDOW_DETECTION & d = detections[k];
+    cv::RotatedRect windowTemp(cv::Point2f(d.x + (d.size / 2), d.y + (d.size / 2)), cv::Size2f(d.size, d.size), -degrees[d.orderDegrees]);
+    windowsCandidatesRotated.push_back(windowTemp);
   }
 
+  #if defined(UVFACE_SCAN_STATISTICS)
+  double startGrouping = cv::getTickCount();
+  #endif
   groupRectanglesRotated(windowsCandidatesRotated, groupThreshold, eps);
+  #if defined(UVFACE_SCAN_STATISTICS)
+  context.scanStatistics.secondsGrouping = context.scanStatistics.secondsGrouping + (cv::getTickCount() - startGrouping) / cv::getTickFrequency();
+  #endif
+
+  if (flagLargestObject && windowsCandidatesRotated.size() > 1) {
+    int largest = 0;
+    for (int i = 1; i < windowsCandidatesRotated.size(); i++)
+      if (windowsCandidatesRotated[i].size.area() > windowsCandidatesRotated[largest].size.area()) largest = i;
+    windowsCandidatesRotated[0] = windowsCandidatesRotated[largest];
+    windowsCandidatesRotated.resize(1);
+  }
 
   // Here we extract the rectangles of the detected objects
   if (listDetectedObjects != NULL) {
 
-    if (flagExtractColorImages == true) {
-
-      image.copyTo(imageAndBackgroundColor(cv::Range(image.rows, 2 * image.rows), cv::Range(image.cols, 2 * image.cols)));
-
-      for (int i = 0; i < windowsCandidatesRotated.size(); i++) {
-        cv::Rect tempBoundingRect = windowsCandidatesRotated[i].boundingRect(); // Bounding rectangle of the rotated rectangle
-        cv::Mat imagesBoundingRect = imageAndBackgroundColor(tempBoundingRect + cv::Point(image.cols, image.rows));
-        cv::Mat M = cv::getRotationMatrix2D(cv::Point2f(tempBoundingRect.width / 2, tempBoundingRect.height / 2), windowsCandidatesRotated[i].angle, 1.0);
-
-        cv::Mat R;
-        cv::warpAffine(imagesBoundingRect, R, M, imagesBoundingRect.size(), cv::INTER_CUBIC);
-
-        getRectSubPix(R, windowsCandidatesRotated[i].size, cv::Point2f(tempBoundingRect.width / 2, tempBoundingRect.height / 2), R);
-
-        listDetectedObjects -> push_back(R);
-      }
-
-    } else {
-
-      imageGray.copyTo(imageAndBackgroundGray(cv::Range(image.rows, 2 * image.rows), cv::Range(image.cols, 2 * image.cols)));
-
-      for (int i = 0; i < windowsCandidatesRotated.size(); i++) {
-        cv::Rect tempBoundingRect = windowsCandidatesRotated[i].boundingRect(); // Bounding rectangle of the rotated rectangle
-        cv::Mat imagesBoundingRect = imageAndBackgroundGray(tempBoundingRect + cv::Point(image.cols, image.rows));
-        cv::Mat M = cv::getRotationMatrix2D(cv::Point2f(tempBoundingRect.width / 2, tempBoundingRect.height / 2), windowsCandidatesRotated[i].angle, 1.0);
-
-        cv::Mat R;
-        cv::warpAffine(imagesBoundingRect, R, M, imagesBoundingRect.size(), cv::INTER_CUBIC);
-
-        getRectSubPix(R, windowsCandidatesRotated[i].size, cv::Point2f(tempBoundingRect.width / 2, tempBoundingRect.height / 2), R);
-
-        listDetectedObjects -> push_back(R);
-      }
+    const cv::Mat & source = flagExtractColorImages ? image : context.imageGray;
 
+    for (int i = 0; i < windowsCandidatesRotated.size(); i++) {
+      cv::Mat R;
+      extractRotatedObject(source, windowsCandidatesRotated[i], R);
+      listDetectedObjects -> push_back(R);
     }
 
   }
@@ -1078,12 +3508,28 @@ void CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesRotatedGrouped(cv::Ma
 
 bool CASCADE_CLASSIFIERS_EVALUATION::FDDB_evaluateClassifier(cv::Mat & image, int scale, int orderDegrees) {
 
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 1
   for (int i = 0; i < numberClassifiersUsed; i++)
     if (!strongLearnsEvaluation[i] -> FDDB_evaluateStrongLearn(image, scale, orderDegrees)) return false; /*Classified as negative label*/
 
   scoreDetection = strongLearnsEvaluation[numberClassifiersUsed - 1] -> scoreDetection; // Detection score is taken
 
   return true; /*Classified as positive label*/
+  #else
+  return FDDB_evaluateClassifier(image.ptr < uchar > (), scale, orderDegrees);
+  #endif
+
+}
+
+bool CASCADE_CLASSIFIERS_EVALUATION::FDDB_evaluateClassifier(const uchar * window, int scale, int orderDegrees) {
+
+  #if DEBUG_OBJECT_GRAPH_EVALUATION == 1
+  cv::Mat windowGraph(highImages, widthImages, CV_8UC1, const_cast < uchar * > (window), defaultContext.imageGray.step); // Only a header, at() must see the stride of imageGray
+  return FDDB_evaluateClassifier(windowGraph, scale, orderDegrees);
+  #else
+  /*The score is the sum of the last strong classifier, it is only meaningful when the window passes all of them*/
+  return flatCascade.evaluate(window, getWindowOffsets(defaultContext, scale, orderDegrees), 0, numberClassifiersUsed, & scoreDetection) == numberClassifiersUsed;
+  #endif
 
 }
 
@@ -1123,7 +3569,7 @@ class FDDB_SimilarRects {
 };
 
 // This function is a modification of the openCV groupRectangles function, used to group neighboring detection rectangles
-void FDDB_groupRectangles(std::vector < FDDB_RECT_AND_SCORES > & rectList, int groupThreshold, double eps,
+void FDDB_groupRectangles(std::vector < FDDB_RECT_AND_SCORES > & rectList, int groupThreshold, double eps, int multiplicity = 1,
   std::vector < int > * weights = NULL, std::vector < double > * levelWeights = NULL) {
   if (groupThreshold <= 0 || rectList.empty()) {
     if (weights) {
@@ -1136,7 +3582,7 @@ void FDDB_groupRectangles(std::vector < FDDB_RECT_AND_SCORES > & rectList, int g
   }
 
   std::vector < int > labels;
-  int nclasses = partition(rectList, labels, FDDB_SimilarRects(eps));
+  int nclasses = partitionByGrid(rectList, labels, FDDB_SimilarRects(eps), eps);
 
   std::vector < FDDB_RECT_AND_SCORES > rrects(nclasses);
   std::vector < int > rweights(nclasses, 0);
@@ -1145,12 +3591,12 @@ void FDDB_groupRectangles(std::vector < FDDB_RECT_AND_SCORES > & rectList, int g
   int i, j, nlabels = (int) labels.size();
   for (i = 0; i < nlabels; i++) {
     int cls = labels[i];
-    rrects[cls].x += rectList[i].x;
-    rrects[cls].y += rectList[i].y;
-    rrects[cls].width += rectList[i].width;
-    rrects[cls].height += rectList[i].height;
-    rrects[cls].score += rectList[i].score;
-    rweights[cls]++;
+    rrects[cls].x += multiplicity * rectList[i].x;
+    rrects[cls].y += multiplicity * rectList[i].y;
+    rrects[cls].width += multiplicity * rectList[i].width;
+    rrects[cls].height += multiplicity * rectList[i].height;
+    rrects[cls].score += multiplicity * rectList[i].score;
+    rweights[cls] += multiplicity;
   }
 
   bool useDefaultWeights = false;
@@ -1224,117 +3670,30 @@ void FDDB_groupRectangles(std::vector < FDDB_RECT_AND_SCORES > & rectList, int g
 
 /* This function detects faces in an image and returns the rectangles of these coordinates and the corresponding scores for each detection, as required by the software provided at http://vis-www.cs.umass.edu/fddb/ */
 void CASCADE_CLASSIFIERS_EVALUATION::FDDB_detectObjectRectanglesGroupedZeroDegrees(cv::Mat & image, std::vector < cv::Rect > & rectanglesDetected, std::vector < double > & scores, bool doubleDetectedList) {
+  FDDB_detectObjectRectanglesGroupedZeroDegrees(defaultContext, image, rectanglesDetected, scores, doubleDetectedList);
+}
 
-  std::vector < FDDB_RECT_AND_SCORES > fddbWindowsCandidates;
-
-  if (szImg != image.size()) {
-    ImageBackground = cv::Mat::zeros(sizeMaxWindow + 2 * zsBackground, sizeMaxWindow + 2 * zsBackground, CV_8UC1);
-    imageGray = ImageBackground(cv::Range(zsBackground, zsBackground + image.rows), cv::Range(zsBackground, zsBackground + image.cols));
-    szImg = image.size();
-  }
-
-  cvtColor(image, imageGray, CV_BGR2GRAY); // Converting to grayscale
-
-  if (flagActivateSkinColor) {
-    cvtColor(image, hsv, CV_BGR2HSV);
-    inRange(hsv, hsvMin, hsvMax, bw);
-    integral(bw, integralBw, CV_32S);
-  }
-
-  int idx = 0;
-
-  if (flagActivateSkinColor) {
-
-    //_______________________________________________________________________________________________________________________//
-    for (int sizeBase = sizeBaseEvaluation; sizeBase <= std::min(image.rows, image.cols); sizeBase = factorScaleWindow * sizeBase, idx++) {
-      int step_x = sizeBase * stepWindow; /* This factor moves the search window in rows */
-      int step_y = sizeBase * stepWindow; /* This factor moves the search window in columns */
-      for (int i = 0; i <= image.rows - sizeBase; i = i + step_x) {
-        for (int j = 0; j <= image.cols - sizeBase; j = j + step_y) {
-
-          /*__________CALCULATION OF WINDOW POSITION______________*/
-          int topLeft_x = i;
-          int topLeft_y = j;
-          int bottomRight_x = sizeBase + i - 1;
-          int bottomRight_y = sizeBase + j - 1;
-          /*____________________________________________________________*/
-
-          cv::Mat window;
-          window = imageGray(cv::Range(topLeft_x, bottomRight_x + 1), cv::Range(topLeft_y, bottomRight_y + 1));
-
-          //___________________________________________________________________________________________//
-          double sum2 = integralBw.at < int > (bottomRight_x + 1, bottomRight_y + 1) + integralBw.at < int > (topLeft_x, topLeft_y) - (integralBw.at < int > (bottomRight_x + 1, topLeft_y) + integralBw.at < int > (topLeft_x, bottomRight_y + 1)); // Integral image evaluation
-
-          if (sum2 > 76.5 * sizeBase * sizeBase) { //76.5=255*0.3
-
-            for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
-              if (FDDB_evaluateClassifier(window, idx, orderDegrees)) {
-
-                FDDB_RECT_AND_SCORES rectTemp(j, i, sizeBase, sizeBase, scoreDetection);
-                fddbWindowsCandidates.push_back(rectTemp);
-
-              }
-            }
-
-          }
-          //___________________________________________________________________________________________//
-
-        }
-      }
-
-    }
-    //_______________________________________________________________________________________________________________________//
-
-  } else {
-
-    //_______________________________________________________________________________________________________________________//
-    for (int sizeBase = sizeBaseEvaluation; sizeBase <= std::min(image.rows, image.cols); sizeBase = factorScaleWindow * sizeBase, idx++) {
-      int step_x = sizeBase * stepWindow; /* This factor moves the search window in rows */
-      int step_y = sizeBase * stepWindow; /* This factor moves the search window in columns */
-      for (int i = 0; i <= image.rows - sizeBase; i = i + step_x) {
-        for (int j = 0; j <= image.cols - sizeBase; j = j + step_y) {
-
-          /*__________CALCULATION OF WINDOW POSITION______________*/
-          int topLeft_x = i;
-          int topLeft_y = j;
-          int bottomRight_x = sizeBase + i - 1;
-          int bottomRight_y = sizeBase + j - 1;
-          /*____________________________________________________________*/
-
-          cv::Mat window;
-          window = imageGray(cv::Range(topLeft_x, bottomRight_x + 1), cv::Range(topLeft_y, bottomRight_y + 1));
-
-          //___________________________________________________________________________________________//
-
-          for (int orderDegrees = 0; orderDegrees < degrees.size(); orderDegrees++) {
-            if (FDDB_evaluateClassifier(window, idx, orderDegrees)) {
-
-              FDDB_RECT_AND_SCORES rectTemp(j, i, sizeBase, sizeBase, scoreDetection);
-              fddbWindowsCandidates.push_back(rectTemp);
-
-            }
-          }
-          //___________________________________________________________________________________________//
+void CASCADE_CLASSIFIERS_EVALUATION::FDDB_detectObjectRectanglesGroupedZeroDegrees(DETECTION_CONTEXT & context, cv::Mat & image, std::vector < cv::Rect > & rectanglesDetected, std::vector < double > & scores, bool doubleDetectedList) const {
 
-        }
-      }
+  std::vector < FDDB_RECT_AND_SCORES > fddbWindowsCandidates;
 
-    }
-    //_______________________________________________________________________________________________________________________//
+  preprocessImage(image, context);
 
-  }
+  std::vector < WINDOW_DETECTION > detections;
+  scanWindows(context, detections);
 
-  if (doubleDetectedList == true) {
-    /* This is done because the function cv::groupRectangles will remove the group that only has one rectangle, so we double the list to avoid these from being removed as they may be sparse when the false negative rate is very low */
-    //________________________________________________________________//
-    int sz = fddbWindowsCandidates.size();
-    for (int i = 0; i < sz; i++)
-      fddbWindowsCandidates.push_back(FDDB_RECT_AND_SCORES(fddbWindowsCandidates[i]));
-    //________________________________________________________________//
-  }
+  for (int k = 0; k < detections.size(); k++)
+    fddbWindowsCandidates.push_back(FDDB_RECT_AND_SCORES(detections[k].x, detections[k].y, detections[k].size, detections[k].size, detections[k].score));
 
   // Grouping similar rectangles
-  FDDB_groupRectangles(fddbWindowsCandidates, groupThreshold, eps);
+  /* With doubleDetectedList each rectangle counts twice, because the grouping removes the groups that only have one rectangle and they may be sparse when the false negative rate is very low */
+  #if defined(UVFACE_SCAN_STATISTICS)
+  double startGrouping = cv::getTickCount();
+  #endif
+  FDDB_groupRectangles(fddbWindowsCandidates, groupThreshold, eps, doubleDetectedList ? 2 : 1);
+  #if defined(UVFACE_SCAN_STATISTICS)
+  context.scanStatistics.secondsGrouping = context.scanStatistics.secondsGrouping + (cv::getTickCount() - startGrouping) / cv::getTickFrequency();
+  #endif
 
   for (int i = 0; i < fddbWindowsCandidates.size(); i++) {
     rectanglesDetected.push_back(fddbWindowsCandidates[i].getRect());
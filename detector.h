@@ -43,6 +43,8 @@
 #include "opencv2/objdetect/objdetect.hpp"
 #include "opencv2/highgui/highgui.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
+//Own headers
+#include "generatedCascade.h"
 //______________________________________________________________________________________
 
 /*
@@ -51,11 +53,34 @@ using the software provided at http://vis-www.cs.umass.edu/fddb/ will be compile
 */
 #define EVALUATION_FDDB 1
 
+/*
+If the following flag is set to 1, the NODE_EVALUATION object graph keeps its own rotated and scaled features and evaluateClassifier walks
+the graph instead of the flattened cascade (see FLAT_CASCADE_EVALUATION). This is only useful to debug the flattened representation.
+*/
+#define DEBUG_OBJECT_GRAPH_EVALUATION 0
+
+/*
+If the following flag is set to 1, every time a cascade is loaded the integer split test of each node (see FLAT_CASCADE_EVALUATION::nodeSplitTest)
+is compared with the NPD table for the 65536 pairs of pixels, and the result is printed.
+*/
+#define VALIDATE_INTEGER_SPLIT_TESTS 0
+
+/*
+Engines that can evaluate the cascade during the sliding window scan (see CASCADE_CLASSIFIERS_EVALUATION::setEvaluationEngine), both give the same detections.
+*/
+enum EVALUATION_ENGINE {
+  EVALUATION_ENGINE_DEPTH_FIRST = 0, //Each window goes through every stage before the next window is evaluated (evaluateClassifier)
+  EVALUATION_ENGINE_BREADTH_FIRST = 1 //Each stage is evaluated on a whole row of windows and only the survivors go to the next stage. With AVX2 (see UVFACE_ENABLE_AVX2 in CMakeLists.txt), 8 windows are evaluated at once with gathers
+};
+
 /*Forward declarations*/
 class NODE_EVALUATION;
 class TREE_TRAINING_EVALUATION;
 class STRONG_LEARN_EVALUATION;
 class CASCADE_CLASSIFIERS_EVALUATION;
+class FLAT_CASCADE_EVALUATION;
+class SCAN_WORK_ITEM;
+class SCAN_MODEL;
 
 typedef double(NODE_EVALUATION:: * PointerToEvaluationNode_Evaluation)(cv::Mat & , int scale, int orderDegrees);
 class NODE_EVALUATION {
@@ -70,7 +95,7 @@ class NODE_EVALUATION {
   double threshold;
   int numFeature;
   cv::Point2i * feature;
-  std::vector < std::vector < int * > > stackFeatures;
+  int numberNode; //Index of the split node in graphFeatures of the parent classifier (the split nodes are numbered depth-first)
   double yt;
 
   PointerToEvaluationNode_Evaluation pointerToFunctionEvaluation; /*Pointer to the evaluation function*/
@@ -84,11 +109,13 @@ class NODE_EVALUATION {
     }
     ~NODE_EVALUATION();
   void loadNode(cv::FileNode nodeRootFile);
-  void initializeFeatures();
+  void initializeFeatures(int & nextNode); //Numbers the split nodes of the subtree from nextNode and fills their coordinates in graphFeatures
   double evaluateNode(cv::Mat & image, int scale, int orderDegrees);
   double evaluateNodeNoTerminal(cv::Mat & image, int scale, int orderDegrees); /*Evaluation function for non-terminal NODE*/
   double evaluationNodeTerminal(cv::Mat & image, int scale, int orderDegrees); /*Evaluation function for terminal node*/
 
+  friend class FLAT_CASCADE_EVALUATION;
+
 };
 
 class TREE_TRAINING_EVALUATION {
@@ -101,9 +128,11 @@ class TREE_TRAINING_EVALUATION {
     TREE_TRAINING_EVALUATION(CASCADE_CLASSIFIERS_EVALUATION * parentClassifier): nodeRoot(NULL), parentClassifier(parentClassifier) {}
     ~TREE_TRAINING_EVALUATION();
   void loadWeakLearn(cv::FileNode weakLearnsTrees, int num);
-  void initializeFeatures();
+  void initializeFeatures(int & nextNode);
   double evaluateTree(cv::Mat & image, int scale, int orderDegrees);
 
+  friend class FLAT_CASCADE_EVALUATION;
+
 };
 
 class STRONG_LEARN_EVALUATION {
@@ -118,26 +147,266 @@ class STRONG_LEARN_EVALUATION {
   void loadStrongLearn(cv::FileNode fileStrongLearn, int stage);
   double evaluateStrongLearnWithZeroThreshold(cv::Mat & image, int scale, int orderDegrees);
   bool evaluateStrongLearn(cv::Mat & image, int scale, int orderDegrees); /*Evaluation using threshold*/
-  void initializeFeatures();
+  void initializeFeatures(int & nextNode);
 
   #if EVALUATION_FDDB == 1
   double scoreDetection; //scoreDetection is the confidence of the detection
   bool FDDB_evaluateStrongLearn(cv::Mat & image, int scale, int orderDegrees);
   #endif
 
+  friend class FLAT_CASCADE_EVALUATION;
+
+};
+
+/*
+The following class stores the cascade compiled into flat arrays. The split nodes of each tree are stored breadth-first and a node is reached
+through its index, a child index greater than or equal to zero is another split node while a negative index ~k is the leaf k. This avoids the
+pointer chasing and the indirect call per node of the NODE_EVALUATION graph, so it is the representation used during the detection.
+*/
+class FLAT_CASCADE_EVALUATION {
+
+  std::vector < int > stageTreeBegin; //The trees of stage s are [stageTreeBegin[s], stageTreeBegin[s + 1])
+  std::vector < double > stageThreshold; //Threshold of each strong classifier
+  std::vector < int > treeRoot; //Root of each tree, the index of a split node or ~k if the whole tree is the leaf k
+  std::vector < int > nodeChildren; //Two entries per split node: left child and right child
+  std::vector < float > nodeThreshold; //Threshold of each split node, rounded so that the comparison with the float NPD table does not change
+  std::vector < int > nodeSplitTest; //Three entries per split node (a, b, c): the node goes right if a * p1 - b * p2 > c, which is the same as NPD > threshold without the table
+  std::vector < cv::Point2i > nodeFeature; //Pixels (indices in the widthImages x highImages training window) compared by each split node
+  std::vector < double > leafValue; //Value (yt) of each leaf, kept in double so that the sums are the same as in the object graph
+  const GENERATED_STAGE_EVALUATION * generatedStages; //If it is not NULL, the strong classifiers are evaluated by the generated code (see generatedCascade.h)
+  std::vector < double > treeRejection; //Rejection trace: a window leaves its stage as soon as the partial sum after tree t is below treeRejection[t]
+  bool flagRejectionTraces; //True if treeRejection is used, the generated code does not know the traces so it is bypassed while they are active
+
+  void compileTree(const NODE_EVALUATION * nodeRoot);
+  bool hasValidIndices(int widthImages, int highImages) const; //The indices of the arrays are inside them and the trees have no cycles, checked on the binary files
+  void generateNodeCode(std::ostream & out, int node, int indentation) const;
+  double evaluateStage(const uchar * window, const int * offsets, int stage) const; //Sum of the trees of the stage
+  double evaluateStageClamped(const cv::Mat & image, int row, int col, int kx, int ky, const short * coordinates, int stage) const; //Same as evaluateStage with the reads of evaluateClamped
+  #if defined(__AVX2__)
+  void evaluateStage8(const uchar * base, const int * offsets, const int * windows, int stage, double * sums) const; //Sums of the trees of the stage for the windows base + windows[0..7]
+  #endif
+
+  public:
+    FLAT_CASCADE_EVALUATION(): generatedStages(NULL), flagRejectionTraces(false) {}
+
+  void clear();
+  void compileStrongLearn(const STRONG_LEARN_EVALUATION * strongLearn);
+  /*Computes the offsets [degree][scale][node][2] of the two pixels of each split node relative to the top-left of the window, in an image whose
+  rows are stride bytes apart. kx and ky are the integer factors of each scale*/
+  void computeOffsets(const std::vector < double > & degrees, const std::vector < int > & kx, const std::vector < int > & ky, int widthImages, int highImages, int stride, std::vector < int > & offsetsTable) const;
+  /*Computes the coordinates [degree][node][4] (row1, col1, row2, col2) of the two pixels of each split node in a widthImages x highImages window,
+  they may be outside the window when the degree is not 0. footprint is the bounding box of all of them*/
+  void computeCoordinates(const std::vector < double > & degrees, int widthImages, int highImages, std::vector < short > & coordinatesTable, cv::Rect & footprint) const;
+  /*Computes the offsets of windows of widthImages x highImages pixels (scale factor 1) in an image whose rows are stride bytes apart, the table
+  is [degree][node][2] and it is the one used in pyramid mode. It depends on the stride of the pyramid, so each DETECTION_CONTEXT keeps its own*/
+  void computePyramidOffsets(const std::vector < double > & degrees, int widthImages, int highImages, int stride, std::vector < int > & offsetsTable) const;
+
+  int getNumberStages() const;
+  double getStageThreshold(int stage) const;
+  int getNumberSplitNodes() const;
+  int getNumberTrees() const;
+  int getNumberTrees(int beginStage, int endStage) const; //Trees of the stages [beginStage, endStage)
+  size_t getModelBytes() const; //Memory used by the trees and their thresholds
+  int validateIntegerSplitTests() const; //Compares nodeSplitTest with the NPD table for all the pairs of pixels and returns the number of disagreements
+  unsigned int getFingerprint() const; //Hash of the compiled cascade (FNV-1a over all its arrays)
+
+  /*Writes a C++ translation unit that defines the symbols of generatedCascade.h for this cascade*/
+  void generateCode(std::ostream & out) const;
+  /*Evaluates the strong classifiers with the generated code from now on, only if it was generated from this same cascade. Returns true if so*/
+  bool attachGeneratedStages(const GENERATED_STAGE_EVALUATION * stages, int numberStages, unsigned int fingerprint);
+
+  /*Binary cascade format: a versioned header followed by the arrays above, so reading it is only copying memory*/
+  void writeBinary(std::ostream & out, int widthImages, int highImages) const;
+  bool readBinary(const char * data, long size, int & widthImages, int & highImages); //Returns false (and leaves the cascade empty) if data is not a valid binary cascade
+
+  /*Evaluates the stages [beginStage, endStage) on the window whose top-left pixel is pointed to by window. Returns the index of the first stage
+  that rejects the window, or endStage if the window passes all of them. If score is not NULL, the sum of the last evaluated stage is stored there*/
+  int evaluate(const uchar * window, const int * offsets, int beginStage, int endStage, double * score = NULL) const;
+  /*Same as evaluate for the window of image whose top-left pixel is (row, col), with its features at the coordinates of computeCoordinates
+  scaled by kx and ky. The coordinates outside image are clamped to its borders, so it can evaluate the windows at the edges of the image*/
+  int evaluateClamped(const cv::Mat & image, int row, int col, int kx, int ky, const short * coordinates, int beginStage, int endStage, double * score = NULL) const;
+
+  /*Evaluates the stages [0, endStage) breadth-first on the windows whose top-left pixels are base + windows[k], k < numberWindows. The windows
+  that pass every stage are compacted (in their original order) at the beginning of windows, with the sum of their last stage in scores.
+  Returns the number of those windows*/
+  int evaluateBreadthFirst(const uchar * base, const int * offsets, int * windows, double * scores, int numberWindows, int endStage, long long * rejectedByStage = NULL) const; //If rejectedByStage is not NULL, the windows rejected by each stage are added to it
+
+  /*Evaluates every stage on the window and stores in partialSums[t] the sum of its stage up to the tree t. Returns true if the window passes all
+  the stages. This is what the calibration of the rejection traces needs*/
+  bool traceWindow(const uchar * window, const int * offsets, double * partialSums) const;
+  bool setRejectionTraces(const std::vector < double > & traces); //Returns false if there is not one value per tree
+  const std::vector < double > & getRejectionTraces() const;
+  void setFlagRejectionTraces(bool rejectionTraces); //The traces can only be activated if they were set
+
+};
+
+/*A window accepted by the cascade during the sliding window scan*/
+class WINDOW_DETECTION {
+  public: WINDOW_DETECTION(int x, int y, int size, int orderDegrees, double score = 0, int model = 0): x(x),
+  y(y),
+  size(size),
+  orderDegrees(orderDegrees),
+  score(score),
+  model(model) {}
+  int x; //Column of the top-left corner
+  int y; //Row of the top-left corner
+  int size; //Side of the window
+  int orderDegrees; //Index in degrees of the angle at which the window was accepted
+  double score; //Sum of the last strong classifier
+  int model; //Index of the cascade that accepted the window in a multi-model scan, 0 otherwise
+};
+
+/*A region of the input image where the detection functions look for objects, only the windows inside region whose side is in [minSizeWindow, maxSizeWindow] are evaluated.
+When the input image is a part of a larger one whose top-left pixel is at -origin (a tile), the windows follow the scan grid of the larger image*/
+class SEARCH_REGION {
+  public: SEARCH_REGION(cv::Rect region, int minSizeWindow, int maxSizeWindow, cv::Point origin = cv::Point(0, 0)): region(region),
+  minSizeWindow(minSizeWindow),
+  maxSizeWindow(maxSizeWindow),
+  origin(origin) {}
+  cv::Rect region;
+  int minSizeWindow;
+  int maxSizeWindow;
+  cv::Point origin;
+};
+
+/*
+Windows where a fixed camera can see an object: the center of the window must be on a nonzero pixel of mask and its side must be between the
+limits of the row of the center, which change linearly from the first row of the image to the last one (a perspective model of the size of the
+objects). The mask is resized to the size of the images with nearest neighbor, the limits are in pixels of the images and the largest side is
+not limited when maxSizeTop and maxSizeBottom are both 0.
+load() reads a cv::FileStorage file with the keys mask (path of an image, relative to the file), minSizeTop, minSizeBottom, maxSizeTop and
+maxSizeBottom, all of them optional
+*/
+class SCAN_MASK {
+  public: SCAN_MASK(): minSizeTop(0),
+  minSizeBottom(0),
+  maxSizeTop(0),
+  maxSizeBottom(0) {}
+  cv::Mat mask; //CV_8UC1, empty if the center of the windows may be anywhere
+  double minSizeTop;
+  double minSizeBottom;
+  double maxSizeTop;
+  double maxSizeBottom;
+  bool load(const std::string & nameFile); //Returns false if the file or its mask could not be read, then the mask is left empty
+  bool isEmpty() const; //True if every window is allowed
+};
+
+/*
+Blocks of the frames of a fixed camera where something moved. Each frame is reduced by factor and converted to gray, the pixels that differ
+from a running average of the previous ones (the background) by more than threshold are moving, and a block of blockSize x blockSize reduced
+pixels is moving when at least minimumFraction of its pixels are. For a 640x480 frame with the default values the map has 20x15 blocks of
+32x32 pixels and the update reads each pixel of the frame once
+*/
+class MOTION_MAP {
+  public: MOTION_MAP(): factor(8),
+  blockSize(4),
+  threshold(15),
+  learningRate(0.05),
+  minimumFraction(0.1) {}
+  int factor;
+  int blockSize;
+  double threshold; //Gray levels
+  double learningRate; //Weight of each frame in the background
+  double minimumFraction;
+
+  /*Adds a frame (CV_8UC1 or CV_8UC3) to the background and computes its moving blocks. Returns false when the background starts with this
+  frame (the first one, or the size of the frames changed), then there are no moving blocks*/
+  bool update(const cv::Mat & frame);
+  /*Bounding rectangles, in pixels of the frames, of the groups of moving blocks that touch each other (also by a corner)*/
+  void getMovingRegions(std::vector < cv::Rect > & regions) const;
+  void clear(); //Forgets the background
+  private:
+  cv::Size sizeFrame;
+  cv::Mat reduced; //CV_8UC1
+  cv::Mat background; //CV_32FC1
+  cv::Mat difference;
+  cv::Mat blocks; //CV_8UC1, nonzero for the moving blocks
+};
+
+/*
+Counters of the sliding window scan. They are only updated when UVFACE_SCAN_STATISTICS is defined (the benchmark tools of CMakeLists.txt
+define it), otherwise they are compiled out and stay at zero
+*/
+class SCAN_STATISTICS {
+  public: SCAN_STATISTICS(): windows(0),
+  trees(0),
+  windowsOtherModels(0),
+  scans(0),
+  secondsScan(0),
+  secondsGrouping(0) {}
+  long long windows; //Windows evaluated, a window evaluated at several angles counts once per angle (and once per model in a multi-model scan)
+  std::vector < long long > rejectedByStage; //Windows rejected by each stage, the others passed all the stages that were used
+  long long trees; //Trees evaluated by those windows (with rejection traces a rejected stage may stop before its last tree, so it is an upper bound)
+  long long windowsOtherModels; //Windows evaluated by the other cascades of a multi-model scan, they are not in rejectedByStage
+  long long scans; //Sliding window scans, one per call to the detection functions (one per scale with flagLargestObject)
+  std::vector < long long > windowsByScale; //Windows evaluated at each scale
+  std::vector < double > secondsByScale; //Seconds spent scanning each scale, summed over the threads of the scan
+  double secondsScan; //Seconds of the sliding window scans, without the preprocessing of the image
+  double secondsGrouping; //Seconds of the grouping of the detections
+  void clear(int numberStages);
+  void countWindow(int stageReached, int endStage); //stageReached is the value returned by FLAT_CASCADE_EVALUATION::evaluate
+  void countWindowOtherModel(int treesEvaluated); //A window evaluated by another cascade of a multi-model scan, its stages are not those of rejectedByStage
+  void add(const SCAN_STATISTICS & statistics);
+  long long getWindowsEntering(int stage) const; //Windows of the cascade that scans that reached the stage, getWindowsEntering(rejectedByStage.size()) passed it
+};
+
+/*
+Scratch buffers of the detection functions. The cascade (CASCADE_CLASSIFIERS_EVALUATION) is only read while it detects, so one loaded cascade
+can serve several threads or camera streams at the same time as long as each one passes its own context and the cascade is not configured
+meanwhile. The buffers are allocated by the first image and reused while the size of the images and the features of the cascade do not change
+*/
+class DETECTION_CONTEXT {
+  std::vector < cv::RotatedRect > windowsCandidatesRotated;
+  std::vector < cv::Rect > windowsCandidates;
+  cv::Mat imageBuffer; //imageGray and one extra row, the gathers of the breadth-first scan read up to three bytes after the pixel of a feature
+  cv::Size szImg; //Width of the last analyzed image
+  cv::Mat imageGray; //Input image in grayscale, it has the size of the input image
+  std::vector < int > featureOffsets; //Offsets (see FLAT_CASCADE_EVALUATION::computeOffsets) of the scales that fit in imageGray for its stride
+  int numberScales; //Number of scales in featureOffsets
+  cv::Mat integralBw; //Integral image of the skin mask (1 for skin pixels), it counts the skin pixels of images of up to 2^31 pixels
+  cv::Mat integralBlocks; //Integral image of the skin of the 8x8 blocks of the skin mask, it discards rows and windows without reading integralBw
+  bool skinColor; //integralBw and integralBlocks are those of imageGray, so the scan applies the skin color test (false for luma planes)
+  cv::Mat pyramidBackground; //Background image where the levels of the pyramid are stacked, only useful in pyramid mode
+  std::vector < cv::Mat > pyramidLevels; //imageGray resized for each scale visited by the detection functions (views of pyramidBackground)
+  std::vector < int > pyramidOffsets; //Offsets of the features in pyramidBackground (see FLAT_CASCADE_EVALUATION::computePyramidOffsets)
+  int featuresVersion; //Version of the features of the cascade for which the buffers were allocated, 0 if they were never allocated
+  SCAN_MASK scanMask; //Windows that may contain an object in the images of this context (see SCAN_MASK)
+  bool scanMaskChanged; //True until maskColumns and maskRows are computed again for scanMask
+  /*For each scale, the first and the last column of the allowed windows whose top-left pixel is in each row of the input image (the first is
+  larger than the last if there are none), and the first and the last of those rows in maskRows. Both are empty when scanMask is empty*/
+  std::vector < std::vector < int > > maskColumns;
+  std::vector < int > maskRows;
+  /*Tables of the other cascades of the last multi-model scan (see CASCADE_CLASSIFIERS_EVALUATION::detectObjectRectanglesMultiModel), for the
+  degrees and scales of the cascade that scans and the strides of imageGray or pyramidBackground. They are computed again with the buffers*/
+  std::vector < const FLAT_CASCADE_EVALUATION * > modelCascades;
+  std::vector < std::vector < int > > modelOffsets;
+  std::vector < std::vector < short > > modelCoordinates;
+  std::vector < cv::Rect > modelFootprints;
+  bool modelPyramid; //The offsets of modelOffsets are those of pyramidBackground
+  SCAN_STATISTICS scanStatistics; //Accumulated over the scans since the last clearScanStatistics()
+  public:
+    DETECTION_CONTEXT(): numberScales(0), skinColor(false), featuresVersion(0), scanMaskChanged(false), modelPyramid(false) {}
+  const SCAN_STATISTICS & getScanStatistics() const; //See SCAN_STATISTICS
+  void clearScanStatistics();
+  void setScanMask(const SCAN_MASK & mask); //Only the windows allowed by mask are scanned from the next image, for example those of one camera
+  size_t getBytes() const; //Memory used by the buffers of the context
+
+  friend class CASCADE_CLASSIFIERS_EVALUATION;
 };
 
 class CASCADE_CLASSIFIERS_EVALUATION {
   std::vector < STRONG_LEARN_EVALUATION * > strongLearnsEvaluation; /*Stores each of the strong classifiers in the cascade*/
-  int numberClassifiersUsed; /*Number of classifiers to use, its value should vary between 1 and strongLearnsEvaluation.size(), by default its value is strongLearnsEvaluation.size()*/
+  FLAT_CASCADE_EVALUATION flatCascade; /*The same cascade compiled into flat arrays, this is what the detection functions evaluate*/
+  int numberClassifiersUsed; /*Number of classifiers to use, its value should vary between 1 and flatCascade.getNumberStages(), by default its value is flatCascade.getNumberStages()*/
   int widthImages;
   int highImages;
-  cv::Point2i * NPD;
   std::vector < double > degrees; //These are the detection degrees, by default 0 degrees
   int sizeBaseEvaluation; //By default, its size is the smallest side of the image size
   double factorScaleWindow; //Factor by which the window will widen
   double stepWindow; //Factor by which the window will move according to its size
-  double sizeMaxWindow; //Maximum size of the search window
+  double sizeMaxWindow; //Maximum size of the search window, the images may be of any size
+  std::vector < int > scaleSizes; //Side of the windows of each scale, from sizeBaseEvaluation up to sizeMaxWindow
+  int sizeTile; //Side of the tiles of detectObjectRectanglesTiled (by default 2048)
 
   //Rectangle parameters for displaying detection
   int lineThicknessRectangles; //Thickness of the lines drawing the rectangles (default is 1)
@@ -147,27 +416,83 @@ class CASCADE_CLASSIFIERS_EVALUATION {
   bool flagActivateSkinColor;
   /*If this variable is true, a simple skin color algorithm is activated, by default it is false.
   Keep in mind that if you are detecting something other than a human face, or if the detector will face very varying lighting conditions, or if the input image is in grayscale, the detection will be affected by skin color as areas outside the human skin color range will be removed.*/
+  bool flagParallelScan; /*If true (default), the sliding window scan is split in bands of rows of a single scale that are evaluated by all the cores with OpenMP. The detections are the same as those of the serial scan*/
+  int evaluationEngine; /*One of EVALUATION_ENGINE, by default EVALUATION_ENGINE_DEPTH_FIRST*/
+  bool flagPyramid; /*If true, the gray image is resized once per scale and the cascade is always evaluated on widthImages x highImages windows of the resized image (see pyramidLevels), by default it is false and the features are scaled instead. The pyramid keeps the two pixels of each feature close in memory, so the cost of a window does not depend on its size, but the detections are not exactly the same as those of the scaled features because of the interpolation*/
+  bool flagCoarseToFine; /*If true, each band is scanned in two passes: the first one evaluates only the first coarseStages stages on a grid coarseStep times sparser than the normal one, and the second one evaluates the whole cascade only on the windows of the normal grid that are at most refinementRadius steps away from a coarse window that passed those stages. By default it is false, because the objects whose coarse windows are all rejected early are lost*/
+  int coarseStep; //Step of the coarse grid, in steps of the normal grid (by default 2)
+  int coarseStages; //Number of stages evaluated in the coarse grid (by default 2)
+  int refinementRadius; //Radius of the refined neighborhood, in steps of the normal grid (by default 1)
+  bool flagAnglePruning; /*If true, the depth-first scan visits the angles of degrees from the one closest to 0 degrees outwards, and an angle is only evaluated if its neighbor towards 0 degrees passed the cascade or was rejected by a stage whose sum was at most anglePruningMargin below its threshold. By default it is false, because an object that is only detected far from 0 degrees may be lost*/
+  double anglePruningMargin; //By default 1, about the weight of one tree
+  bool flagLargestObject; /*If true, detectObjectRectanglesGroupedZeroDegrees and detectObjectRectanglesRotatedGrouped only return the largest object: the scales are scanned from the largest one, and the scan stops once the detections found so far form a group and the remaining scales are too small to be similar to any window of the groups (see scanWindowsLargestFirst). By default it is false*/
+  int minSizeObject; //Smallest side of the windows scanned when flagLargestObject is true (by default 0, no limit besides sizeBaseEvaluation)
+  int maxSizeObject; //Largest side of the windows scanned when flagLargestObject is true (by default INT_MAX, no limit besides sizeMaxWindow)
+  cv::Size sizeExtractedObjects; /*Size of the images returned by detectObjectRectanglesRotatedGrouped, each one is sampled once from the input image with a single affine transform. By default it is empty and the images have the size of their detection window*/
   bool flagExtractColorImages; /*Controls whether the detected images are returned in color (from the input image) or in grayscale, by default it is false, meaning the images are returned in grayscale*/
 
-  /*Important variables during execution*/
-  std::vector < cv::RotatedRect > windowsCandidatesRotated;
-  std::vector < cv::Rect > windowsCandidates;
-  cv::Mat ImageBackground; //Extra background image to avoid errors when evaluating features that go beyond image borders
-  int zsBackground; //Width that the image to analyze must have to avoid evaluating features at non-existent coordinates
-  cv::Size szImg; //Width of the last analyzed image
-  cv::Mat imageAndBackgroundColor; //Only useful for detectObjectRectanglesRotatedGrouped function
-  cv::Mat imageAndBackgroundGray; //Only useful for detectObjectRectanglesRotatedGrouped function
-  cv::Mat imageGray; /*This matrix will be used by each high-level detection function (including those belonging to the FDDB database evaluation) to embed the much smaller input image (see zsBackground variable) to avoid memory access errors when analyzing rectangles (sliding window) at the image edges*/
-  cv::Mat hsv; //Skin Color
-  cv::Mat bw; //Skin Color
-  cv::Mat integralBw; //Integral image of bw
+  /*Important variables during execution, the scratch buffers of each detection are in DETECTION_CONTEXT*/
+  std::vector < short > featureCoordinates; //Coordinates of the features of flatCascade for each degree (see FLAT_CASCADE_EVALUATION::computeCoordinates)
+  cv::Rect featureFootprint; //Bounding box of featureCoordinates, a window whose footprint is inside the image is evaluated without clamping
+  int featuresVersion; //Changes every time initializeFeatures() is called, so the contexts know that their buffers must be allocated again
+  std::vector < uchar > skinLookup; //Bitset of 2^24 bits, the bit (r << 16) | (g << 8) | b is 1 if that color is in [hsvMin, hsvMax] in the hsv space
+  cv::Scalar skinLookupHsvMin; //hsvMin when skinLookup was built
+  cv::Scalar skinLookupHsvMax; //hsvMax when skinLookup was built
   cv::Scalar hsvMin; //Minimum value in the hsv space accepted as skin color
   cv::Scalar hsvMax; //Maximum value in the hsv space accepted as skin color
+  DETECTION_CONTEXT defaultContext; //Context of the detection functions that do not receive one
+  /*Coordinates (row1, col1, row2, col2) of the two pixels of each split node of the object graph in a window of widthImages x highImages pixels,
+  laid out [degree][node][4] in a single arena so that a window reads the nodes of its degree contiguously. They are multiplied by the factors
+  of the scale when they are read. Only used with DEBUG_OBJECT_GRAPH_EVALUATION*/
+  std::vector < short > graphFeatures;
+  int numberGraphNodes; //Number of split nodes of the object graph
 
   cv::FileStorage * fileCascadeClassifier;
-  void generateFeatures();
   void loadCascadeClasifier();
+  static bool isBinaryCascadeFile(const std::string & nameFile);
+  void loadBinaryCascade(const std::string & nameFile); //Only flatCascade is filled, so the object graph (DEBUG_OBJECT_GRAPH_EVALUATION) needs the XML file
+  void prepareFlatCascade(); //Called by both loaders once flatCascade is complete
+
+  void preprocessImage(const cv::Mat & image, DETECTION_CONTEXT & context) const; //Fills imageGray (and integralBw if skin color is activated) of the context from the input image
+  void preprocessLuma(const cv::Mat & luma, DETECTION_CONTEXT & context) const; //Fills imageGray from a CV_8UC1 image, without the skin color test
+  bool allocateBuffers(const cv::Size & size, DETECTION_CONTEXT & context) const; //Buffers and offsets of the context for images of size, true if they changed
+  void buildSkinLookup();
+  void updateSkinLookup(); //Builds skinLookup again if skin color is activated and hsvMin or hsvMax changed, so the detection only reads it
+  void preprocessSkinColor(const cv::Mat & image, DETECTION_CONTEXT & context) const; //Fills imageGray, integralBw and integralBlocks in a single pass over the input image
+  bool rowMayHaveSkinColor(const DETECTION_CONTEXT & context, int row, int size) const; //False if no window of size pixels with its top row at row passes the skin color test
+  bool windowHasSkinColor(const DETECTION_CONTEXT & context, int row, int col, int size) const; //Skin color test of a window of the input image
+  void buildPyramid(DETECTION_CONTEXT & context, bool newSize) const; //Fills pyramidLevels from imageGray, the levels are allocated again if newSize is true
+  const int * getWindowOffsets(const DETECTION_CONTEXT & context, int scale, int orderDegrees) const; //Offsets of the features of the windows of a scan
+  void computeScanMask(DETECTION_CONTEXT & context) const; //Fills maskColumns and maskRows of the context for the size of its imageGray
+  /*Columns [firstCol, lastCol] (in item.image) of the windows of the item allowed by the scan mask of the context, in the row of item.image that
+  starts at the row topLeft_x of the input image. Returns false if there are none*/
+  bool getColumnsOfRow(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, int topLeft_x, int & firstCol, int & lastCol) const;
+  cv::Rect getWindowsInside(const SCAN_WORK_ITEM & item, const cv::Rect & footprint) const; //Top-left pixels (in item.image) of the windows whose features (of bounding box footprint) are all inside item.image
+  /*Evaluates the stages [beginStage, endStage) on the window of the item whose top-left pixel is (row, col), inside tells whether its features
+  are all inside item.image (see getWindowsInside), otherwise they are read with evaluateClamped*/
+  int evaluateWindow(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, bool inside, int row, int col, int orderDegrees, int beginStage, int endStage, double * score) const;
+  void scanBand(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, std::vector < WINDOW_DETECTION > & detections) const; //Scans the windows of a work item, the detections are in coordinates of the input image
+  void scanBandBreadthFirst(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, std::vector < WINDOW_DETECTION > & detections) const; //Same as scanBand with EVALUATION_ENGINE_BREADTH_FIRST
+  void scanBandCoarseToFine(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, std::vector < WINDOW_DETECTION > & detections) const; //Same as scanBand with flagCoarseToFine
+  /*Evaluates the window at the angles allowed by flagAnglePruning, anglesSorted are the indices of degrees sorted by angle and reference is the
+  position in anglesSorted of the angle closest to 0. stageReached[orderDegrees] is the value returned by evaluate (-1 if the angle was pruned)*/
+  void evaluatePrunedAngles(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, bool inside, int row, int col, const std::vector < int > & anglesSorted, int reference, int * stageReached, double * scores) const;
+  bool angleIsPromising(int stageReached, double score) const; //True if the neighbors of an angle with this result must be evaluated
+  void extractRotatedObject(const cv::Mat & source, const cv::RotatedRect & window, cv::Mat & object) const; //Samples the window of source into object, the pixels outside source are black
+  /*Scans the imageGray of the context at every scale (or only at onlyScale) and degree, or only the windows of searchRegions when it is not NULL.
+  With models, every window is evaluated by each of them (see scanBandMultiModel)*/
+  void scanWindows(DETECTION_CONTEXT & context, std::vector < WINDOW_DETECTION > & detections, const std::vector < SEARCH_REGION > * searchRegions = NULL, int onlyScale = -1, const std::vector < SCAN_MODEL > * models = NULL) const;
+  /*Same as scanBand, but each window is evaluated by every model in turn, the detections are tagged with the index of the model in models*/
+  void scanBandMultiModel(const DETECTION_CONTEXT & context, const SCAN_WORK_ITEM & item, const std::vector < SCAN_MODEL > & models, std::vector < WINDOW_DETECTION > & detections) const;
+  /*This cascade and the others that have windows of the same size, with their tables in the context (see DETECTION_CONTEXT::modelCascades)*/
+  void prepareModels(DETECTION_CONTEXT & context, const std::vector < const CASCADE_CLASSIFIERS_EVALUATION * > & others, std::vector < SCAN_MODEL > & models) const;
+  /*Scans the scales from the largest one until the detections form a group (one that survives groupThreshold, each detection counting
+  multiplicity times, with the predicate of groupRectanglesRotated if rotated and of groupRectanglesZeroDegrees otherwise) and down to the
+  first scale whose windows are too small to be similar to any window of those groups, so they are the same as with all the scales. The
+  detections of all the scanned scales are appended to detections*/
+  void scanWindowsLargestFirst(DETECTION_CONTEXT & context, std::vector < WINDOW_DETECTION > & detections, const std::vector < SEARCH_REGION > * searchRegions, int multiplicity, bool rotated) const;
   public:
+    /*nameFile is either a cascade in XML (read with cv::FileStorage) or a binary cascade written by saveBinaryCascade, the format is detected from the file*/
     CASCADE_CLASSIFIERS_EVALUATION(std::string nameFile);
   ~CASCADE_CLASSIFIERS_EVALUATION();
 
@@ -177,7 +502,8 @@ class CASCADE_CLASSIFIERS_EVALUATION {
   void setSizeBase(int sizeBase); //Sets the smallest size for the search window
   void setFactorScaleWindow(double factorScale); //Sets the factor by which the search window will widen
   void setStepWindow(double factorStep); //Sets the factor by which the window will move according to its size
-  void setSizeMaxWindow(double maxSize); //Sets the maximum size of the search window
+  void setSizeMaxWindow(double maxSize); //Sets the maximum size of the search window, it does not limit the size of the images
+  void setFlagPyramid(bool pyramid); //Evaluates the cascade on an image pyramid instead of scaling its features (see flagPyramid)
   //______________________________________________________________________________________________________________________________
   void setLineThicknessRectangles(int thicknessRectangles);
   void setColorRectangles(const cv::Scalar & color);
@@ -194,29 +520,102 @@ class CASCADE_CLASSIFIERS_EVALUATION {
 
   void setFlagActivateSkinColor(bool activateSkinColor);
   void setFlagExtractColorImages(bool extractColorImages);
+  void setSizeExtractedObjects(const cv::Size & size); //For example the size of the images of the facial recognizer (see sizeExtractedObjects)
   void setNumberClassifiersUsed(int number); //Sets the number of classifiers to use
+  void setFlagParallelScan(bool parallelScan);
+  void setEvaluationEngine(int engine); //One of EVALUATION_ENGINE
+  void setFlagCoarseToFine(bool coarseToFine);
+  void setCoarseStep(int step); //Step of the coarse grid in steps of the normal grid, at least 1
+  void setCoarseStages(int stages); //Stages evaluated in the coarse grid, at least 1
+  void setRefinementRadius(int radius); //Neighborhood refined around each coarse candidate in steps of the normal grid, at least 0
+  void setFlagAnglePruning(bool anglePruning); //Only used by the depth-first scan (see flagAnglePruning)
+  void setAnglePruningMargin(double margin);
+  void setFlagLargestObject(bool largestObject); //See flagLargestObject
+  void setSizeLimitsObject(int minSize, int maxSize); //Sides of the windows scanned when flagLargestObject is true
+  void setSizeTile(int size); //See detectObjectRectanglesTiled, at least 4 times sizeBaseEvaluation
   void setHsvMin(const cv::Scalar & hsv);
   void setHsvMax(const cv::Scalar & hsv);
 
   //________Get functions_______________//
   int getNumberStrongLearns() const; //Returns the total number of strong classifiers in the cascade
   double getSizeMaxWindow() const; //Returns the maximum size of the search window
+  bool hasSameWindows(const CASCADE_CLASSIFIERS_EVALUATION & other) const; //True if other can be a model of detectObjectRectanglesMultiModel
   cv::Scalar getHsvMin() const;
   cv::Scalar getHsvMax() const;
+  void generateCascadeCode(std::ostream & out) const; //Writes the loaded cascade as C++ code (see generatedCascade.h)
+  bool saveBinaryCascade(const std::string & nameFile) const; //Writes the loaded cascade in the binary format, it loads much faster than the XML
+  void reportMemory(std::ostream & out) const; //Writes the memory used by the cascade and by its own context
+
+  /*
+  Rejection traces (soft cascade): each tree gets the minimum partial sum of its stage reached by a set of positive windows that pass the
+  whole cascade, so during the detection a window leaves its stage as soon as its partial sum is below that value. All the calibration
+  positives are still detected, but other faces may be lost, so the traces are only used after setFlagRejectionTraces(true). The
+  constructor loads the file <cascade file>.traces.xml if it exists (see tools/calibrateRejectionTraces.cpp).
+  */
+  bool calibrateRejectionTraces(const std::vector < cv::Mat > & positives); //positives are crops of the object, of any size, in color or in grayscale
+  bool saveRejectionTraces(const std::string & nameFile) const;
+  bool loadRejectionTraces(const std::string & nameFile); //Returns false if the file does not exist or was calibrated for another cascade
+  void setFlagRejectionTraces(bool rejectionTraces);
+
+  const SCAN_STATISTICS & getScanStatistics() const; //Statistics of the detection functions that do not receive a context (see SCAN_STATISTICS)
+  void clearScanStatistics();
+  /*Scan mask of the detection functions that do not receive a context. The constructor loads <cascade file>.mask.xml if it exists*/
+  void setScanMask(const SCAN_MASK & mask);
 
   //____________________________________//
 
   //The following functions are the lowest-level detection functions
   bool evaluateClassifier(cv::Mat & image, int scale, int orderDegrees);
   bool evaluateClassifier(cv::Mat & image, int scale, int orderDegrees, int begin, int end);
+  /*Same as above, window points to the top-left pixel of a window inside the imageGray of the context of the cascade (the last image analyzed by
+  the detection functions without a context), and all its features must be inside that image*/
+  bool evaluateClassifier(const uchar * window, int scale, int orderDegrees);
 
   //______________Here are some useful detection functions___________________//
+  /*Each detection function has two versions: the one that receives a DETECTION_CONTEXT only reads the cascade, so it can be called at the same
+  time from several threads with different contexts, and the other one uses the context of the cascade, so it is for a single thread*/
   /*The following function detects an object (with the option for skin color) but does not group similar rectangles*/
-  void detectObjectRectanglesUngrouped(cv::Mat & image);
+  void detectObjectRectanglesUngrouped(cv::Mat & image, const std::vector < SEARCH_REGION > * searchRegions = NULL);
+  void detectObjectRectanglesUngrouped(DETECTION_CONTEXT & context, cv::Mat & image, const std::vector < SEARCH_REGION > * searchRegions = NULL) const;
   /*The following function has the option to double the number of detections in an internal list before grouping the rectangles. This is because the OpenCV algorithm cv::groupRectangles removes rectangles whose group contains fewer or equal to groupThreshold. This is an issue when the classifier has a low false positive rate, as detections are very localized and tend to have few neighbors. This problem may also occur when detection is done from a single angle, so doubling the list prevents many correct detections from being removed by the algorithm.*/
-  void detectObjectRectanglesGroupedZeroDegrees(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects = NULL, std::vector < cv::Rect > * coordinatesDetectedObjects = NULL, bool doubleDetectedList = true, bool paintDetections = true);
+  void detectObjectRectanglesGroupedZeroDegrees(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects = NULL, std::vector < cv::Rect > * coordinatesDetectedObjects = NULL, bool doubleDetectedList = true, bool paintDetections = true, const std::vector < SEARCH_REGION > * searchRegions = NULL);
+  void detectObjectRectanglesGroupedZeroDegrees(DETECTION_CONTEXT & context, cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects = NULL, std::vector < cv::Rect > * coordinatesDetectedObjects = NULL, bool doubleDetectedList = true, bool paintDetections = true, const std::vector < SEARCH_REGION > * searchRegions = NULL) const;
   /*The following function detects the object at the set angles and may optionally extract those regions from the image, normalize them to the standard training angle, and return them in the list std::vector<cv::Mat> listDetectedObjects */
-  void detectObjectRectanglesRotatedGrouped(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects = NULL, std::vector < cv::RotatedRect > * coordinatesDetectedObjects = NULL, bool paintDetections = true);
+  void detectObjectRectanglesRotatedGrouped(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects = NULL, std::vector < cv::RotatedRect > * coordinatesDetectedObjects = NULL, bool paintDetections = true, const std::vector < SEARCH_REGION > * searchRegions = NULL);
+  void detectObjectRectanglesRotatedGrouped(DETECTION_CONTEXT & context, cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects = NULL, std::vector < cv::RotatedRect > * coordinatesDetectedObjects = NULL, bool paintDetections = true, const std::vector < SEARCH_REGION > * searchRegions = NULL) const;
+  /*Detects with this cascade and the cascades of others (for example frontal and profile models) in a single scan: the image is preprocessed once
+  and every window of the scan of this cascade (its degrees, scales, step, skin color and scan mask) is evaluated by each model, up to the first
+  stage that rejects it. Only the stages of the other cascades are used, and those whose windows do not have the size of this one are ignored
+  silently (check them once with hasSameWindows).
+  The detections of each model are grouped on their own with the grouping parameters of this cascade, modelIds[i] is the model of
+  rectangles[i]: 0 for this cascade and k for others[k - 1]. The multi-model scan is always depth-first. The stages of the models are not
+  shared, each model evaluates its own cascade on every window, so the evaluations cost about as much as one scan per model and only the
+  preprocessing, the skin color test and the scan mask are done once*/
+  void detectObjectRectanglesMultiModel(cv::Mat & image, const std::vector < const CASCADE_CLASSIFIERS_EVALUATION * > & others, std::vector < cv::Rect > & rectangles, std::vector < int > & modelIds, bool doubleDetectedList = true, bool paintDetections = true, const std::vector < SEARCH_REGION > * searchRegions = NULL);
+  void detectObjectRectanglesMultiModel(DETECTION_CONTEXT & context, cv::Mat & image, const std::vector < const CASCADE_CLASSIFIERS_EVALUATION * > & others, std::vector < cv::Rect > & rectangles, std::vector < int > & modelIds, bool doubleDetectedList = true, bool paintDetections = true, const std::vector < SEARCH_REGION > * searchRegions = NULL) const;
+  /*Same as detectObjectRectanglesGroupedZeroDegrees for images much larger than sizeTile (photos of tens of megapixels). The image is split in
+  sizeTile x sizeTile tiles that overlap by a quarter of a tile, and each tile is scanned with its own buffers (in parallel with flagParallelScan)
+  for the windows up to that overlap whose top-left corner belongs to it, so every window is scanned once. The larger windows are scanned in a
+  copy of the image reduced to sizeTile, so they are not those of a single scan: their sides are the sides of scaleSizes times the reduction
+  and their positions are on the grid of the reduced copy, and the objects larger than the overlap may be found with less accuracy than in
+  detectObjectRectanglesGroupedZeroDegrees (a larger sizeTile leaves fewer of them to the reduced copy). All the windows are grouped together
+  in the coordinates of the image, so the objects on the borders of the tiles are found once. The scan mask of the context is applied to the
+  tiles (cropped to each one) and to the reduced copy (with its size limits reduced). The buffers take memory in proportion to the tiles, not
+  to the image; the context only holds those of the reduced copy. Images that fit in a tile are detected with
+  detectObjectRectanglesGroupedZeroDegrees*/
+  void detectObjectRectanglesTiled(cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects = NULL, std::vector < cv::Rect > * coordinatesDetectedObjects = NULL, bool doubleDetectedList = true, bool paintDetections = true);
+  void detectObjectRectanglesTiled(DETECTION_CONTEXT & context, cv::Mat & image, std::vector < cv::Mat > * listDetectedObjects = NULL, std::vector < cv::Rect > * coordinatesDetectedObjects = NULL, bool doubleDetectedList = true, bool paintDetections = true) const;
+  /*Same as detectObjectRectanglesGroupedZeroDegrees for the luma (Y) plane of a camera frame (YUYV, NV12, I420 or a decoded MJPEG), which
+  already is the grayscale image: width x height bytes whose rows start every stride bytes. The plane is copied row by row into imageGray, so
+  there is no conversion from BGR, and the skin color test is not applied because there is no color. With mirrored the rectangles (and
+  searchRegions) are those of the frame flipped around its vertical axis: the plane is scanned as it is and the x coordinates of the windows
+  are flipped, instead of copying the flipped frame (the zero degrees windows of a face detector are almost symmetric). Nothing is drawn,
+  extractDetectedObjects builds the crops of the final rectangles only*/
+  void detectObjectRectanglesLuma(const uchar * luma, int width, int height, size_t stride, bool mirrored, std::vector < cv::Rect > & rectangles, bool doubleDetectedList = true, const std::vector < SEARCH_REGION > * searchRegions = NULL);
+  void detectObjectRectanglesLuma(DETECTION_CONTEXT & context, const uchar * luma, int width, int height, size_t stride, bool mirrored, std::vector < cv::Rect > & rectangles, bool doubleDetectedList = true, const std::vector < SEARCH_REGION > * searchRegions = NULL) const;
+  /*Crops of rectangles (given as by detectObjectRectanglesLuma) from frame, which is not flipped: CV_8UC3 (BGR) or CV_8UC1 (the luma plane).
+  The color crops are converted to gray unless flagExtractColorImages is true, and each crop is flipped when mirrored is true*/
+  void extractDetectedObjects(const cv::Mat & frame, const std::vector < cv::Rect > & rectangles, bool mirrored, std::vector < cv::Mat > & objects) const;
   //_______________________________________________________________________________________________________________//
 
   /*The following methods and variables are only useful for my undergraduate thesis. These methods are responsible for extracting rectangles with the score of each detection and will be used by the software provided by the FDDB database (http://vis-www.cs.umass.edu/fddb/). For clarity, each function or class related to the following functions and variables will start with the prefix FDDB.*/
@@ -224,7 +623,9 @@ class CASCADE_CLASSIFIERS_EVALUATION {
   //The following function is used for the FDDB database evaluation
   double scoreDetection; //scoreDetection is the confidence of the detection
   bool FDDB_evaluateClassifier(cv::Mat & image, int scale, int orderDegrees);
+  bool FDDB_evaluateClassifier(const uchar * window, int scale, int orderDegrees);
   void FDDB_detectObjectRectanglesGroupedZeroDegrees(cv::Mat & image, std::vector < cv::Rect > & rectanglesDetected, std::vector < double > & scores, bool doubleDetectedList = true);
+  void FDDB_detectObjectRectanglesGroupedZeroDegrees(DETECTION_CONTEXT & context, cv::Mat & image, std::vector < cv::Rect > & rectanglesDetected, std::vector < double > & scores, bool doubleDetectedList = true) const;
   #endif
 
   friend class STRONG_LEARN_EVALUATION;
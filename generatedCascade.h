@@ -0,0 +1,54 @@
+/***************************************************************************
+**                                                                        **
+**  This source code is part of UVface++, a system developed by           **
+**  Roger Figueroa Quintero as part of his undergraduate thesis titled:   **
+**  "Image Analysis System for Face Detection and Recognition"            **
+**  at Universidad del Valle, Cali, Colombia.                             **
+**                                                                        **
+**  Copyright (C) 2016-2024 Roger Figueroa Quintero                       **
+**                                                                        **
+**  This software is licensed for non-commercial use only. Redistribution **
+**  and use in source and binary forms, with or without modification, are **
+**  permitted provided that the following conditions are met:             **
+**                                                                        **
+**  1. Redistributions of source code must retain the above copyright     **
+**     notice, this list of conditions, and the following disclaimer.     **
+**  2. Redistributions in binary form must reproduce the above copyright  **
+**     notice, this list of conditions, and the following disclaimer in   **
+**     the documentation and/or other materials provided with the         **
+**     distribution.                                                      **
+**  3. The name of the author may not be used to endorse or promote       **
+**     products derived from this software without specific prior written **
+**     permission.                                                        **
+**  4. This software is to be used for non-commercial purposes only.      **
+**                                                                        **
+**  This software is distributed in the hope that it will be useful, but  **
+**  WITHOUT ANY WARRANTY; without even the implied warranty of            **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                  **
+**                                                                        **
+****************************************************************************
+**           Author: Roger Figueroa Quintero                              **
+**  Contact Email: roggerfq@hotmail.com                                   **
+**          Date: First developed: November 2016                          **
+**                Last modified: December 2024                            **
+****************************************************************************/
+
+
+#ifndef GENERATED_CASCADE_H
+#define GENERATED_CASCADE_H
+
+/*
+The following declarations are defined by the translation unit that tools/generateCascadeCode.cpp writes for a cascade file. In that unit
+every strong classifier is a function whose trees are unrolled into nested comparisons with constant coefficients and leaf values, the
+pixel offsets still come from the runtime tables of FLAT_CASCADE_EVALUATION (they depend on the scale, degree and stride). It is only
+compiled when CMake is configured with UVFACE_GENERATED_CASCADE=ON (see CMakeLists.txt).
+*/
+
+/*Returns the sum of the trees of one strong classifier for the window whose top-left pixel is window*/
+typedef double( * GENERATED_STAGE_EVALUATION)(const unsigned char * window, const int * offsets);
+
+extern const unsigned int GENERATED_CASCADE_FINGERPRINT; //FLAT_CASCADE_EVALUATION::getFingerprint() of the cascade that generated the code
+extern const int GENERATED_CASCADE_NUMBER_STAGES;
+extern const GENERATED_STAGE_EVALUATION GENERATED_CASCADE_STAGES[];
+
+#endif
@@ -48,6 +48,7 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QIntValidator>
+#include <climits>
 
 #define inTest 0
 
@@ -68,9 +69,93 @@ threadDetector::threadDetector() {
   detectorIsLoad = false;
   normalizeRotation = false;
   doubleList = false;
+  trackerGuided = false;
+  motionGated = false;
+  motionMap = new MOTION_MAP;
+  framesBetweenFullScans = 10;
+  framesSinceFullScan = 0;
+  trackingChanged = false;
   command = 0; // Means it does nothing
 }
 
+void threadDetector::setTrackingConfig(bool trackerGuided, bool motionGated, int framesBetweenFullScans, int motionThreshold) {
+  QMutexLocker locker( & mutex);
+  pendingTrackerGuided = trackerGuided;
+  pendingMotionGated = motionGated;
+  pendingFramesBetweenFullScans = std::max(1, framesBetweenFullScans);
+  pendingMotionThreshold = motionThreshold;
+  trackingChanged = true;
+  if (!isRunning()) applyTrackingConfig(); // There is no frame to wait for
+}
+
+void threadDetector::applyTrackingConfig() {
+  trackerGuided = pendingTrackerGuided;
+  motionGated = pendingMotionGated;
+  framesBetweenFullScans = pendingFramesBetweenFullScans;
+  framesSinceFullScan = 0;
+  tracks.clear();
+  motionMap -> threshold = pendingMotionThreshold;
+  motionMap -> clear();
+  trackingChanged = false;
+}
+
+bool threadDetector::searchRegionsOfFrame(const cv::Mat & frame, std::vector < SEARCH_REGION > & searchRegions) {
+
+  searchRegions.clear();
+
+  /*The background follows every frame, also those that are scanned completely*/
+  bool motionKnown = motionGated && motionMap -> update(frame);
+
+  if (!(motionKnown || (trackerGuided && !tracks.empty())) || framesSinceFullScan + 1 >= framesBetweenFullScans) {
+    framesSinceFullScan = 0;
+    return false;
+  }
+  framesSinceFullScan++;
+
+  /*Each track is searched in a region half its size larger on each side, at the scales close to its size*/
+  for (int k = 0; k < tracks.size(); k++) {
+    int size = std::max(tracks[k].width, tracks[k].height);
+    int margin = size / 2;
+    searchRegions.push_back(SEARCH_REGION(cv::Rect(tracks[k].x - margin, tracks[k].y - margin, tracks[k].width + 2 * margin, tracks[k].height + 2 * margin), int(0.7 * size), int(1.4 * size)));
+  }
+
+  /*A moving object usually changes a region about its size, so each group of moving blocks is also searched half its size larger on each side, at
+  every scale that fits*/
+  if (motionKnown) {
+    std::vector < cv::Rect > regions;
+    motionMap -> getMovingRegions(regions);
+    for (int k = 0; k < regions.size(); k++) {
+      int margin = std::max(regions[k].width, regions[k].height) / 2;
+      searchRegions.push_back(SEARCH_REGION(cv::Rect(regions[k].x - margin, regions[k].y - margin, regions[k].width + 2 * margin, regions[k].height + 2 * margin), 0, INT_MAX));
+    }
+  }
+  return true;
+
+}
+
+void threadDetector::updateTracks(const std::vector < cv::Rect > & coordinatesDetectedObjects) {
+  tracks = coordinatesDetectedObjects;
+}
+
+void threadDetector::updateTracks(const std::vector < cv::RotatedRect > & coordinatesDetectedObjectsRotated) {
+  tracks.clear();
+  for (int k = 0; k < coordinatesDetectedObjectsRotated.size(); k++)
+    tracks.push_back(coordinatesDetectedObjectsRotated[k].boundingRect());
+}
+
+void threadDetector::loadScanMask(const std::string & nameStream) {
+
+  if (objectDetector == NULL) return;
+
+  SCAN_MASK scanMask; // Empty if neither file exists, then the whole frame is scanned
+  if (scanMask.load(nameDetector + "." + nameStream + ".xml"))
+    std::cout << "Scan mask of " << nameStream << " loaded\n";
+  else
+    scanMask.load(nameDetector + ".mask.xml");
+  objectDetector -> setScanMask(scanMask);
+
+}
+
 threadDetector::~threadDetector() {
   stop();
   wait();
@@ -78,6 +163,7 @@ threadDetector::~threadDetector() {
     delete objectDetector;
     objectDetector = NULL;
   }
+  delete motionMap;
   std::cout << "THE DETECTOR THREAD HAS BEEN DESTROYED\n";
 }
 
@@ -94,7 +180,6 @@ int threadDetector::detectObjectVideoCamera(int device) {
   NOTE: Returns:
   -1 when everything went well
   0 when it cannot open the device
-  greater than zero, when the frame size exceeds the maximum window size, it returns that value
   */
 
   if (isRunning()) { // In case there is an ongoing task
@@ -121,13 +206,9 @@ int threadDetector::detectObjectVideoCamera(int device) {
     return 0; // In case opening the device fails
   }
 
-  // Protection against images larger than allowed size
-  int tempMaxSide = std::max(cap.get(CV_CAP_PROP_FRAME_WIDTH), cap.get(CV_CAP_PROP_FRAME_HEIGHT));
-  if (tempMaxSide > getSizeMaxWindow()) {
-    cap.release();
-    emit clearLabelVideo(); // We leave the graphic label clean
-    return tempMaxSide; // In case the search window size is smaller than the largest side of a frame
-  }
+  loadScanMask(device == -1 ? std::string("cameraUrl") : "camera" + QString::number(device).toStdString());
+  motionMap -> clear(); // The background of another stream is not valid
+  tracks.clear();
 
   command = 1;
   stopped = false;
@@ -140,7 +221,6 @@ int threadDetector::detectObjectVideoFile(std::string nameFileVideo) {
   NOTE: Returns:
   -1 when everything went well
   0 when it cannot open the device
-  greater than zero, when the frame size exceeds the maximum window size, it returns that value
   */
 
   if (isRunning()) { // In case there is an ongoing task
@@ -154,13 +234,9 @@ int threadDetector::detectObjectVideoFile(std::string nameFileVideo) {
     return 0; // In case opening the device fails
   }
 
-  // Protection against images larger than allowed size
-  int tempMaxSide = std::max(cap.get(CV_CAP_PROP_FRAME_WIDTH), cap.get(CV_CAP_PROP_FRAME_HEIGHT));
-  if (tempMaxSide > getSizeMaxWindow()) {
-    cap.release();
-    emit clearLabelVideo(); // We leave the graphic label clean
-    return tempMaxSide;
-  }
+  loadScanMask("video");
+  motionMap -> clear();
+  tracks.clear();
 
   command = 2;
   stopped = false;
@@ -174,7 +250,6 @@ int threadDetector::detectObjectImageFile(std::string nameFileImage) {
   NOTE: Returns:
   -1 when everything went well
   0 when it cannot open the device
-  greater than zero, when the frame size exceeds the maximum window size, it returns that value
   */
 
   if (isRunning()) { // In case there is an ongoing task
@@ -188,12 +263,7 @@ int threadDetector::detectObjectImageFile(std::string nameFileImage) {
     return 0; // Protection against corrupted images
   }
 
-  // Protection against images larger than allowed size
-  int tempMaxSide = std::max(currentImage.rows, currentImage.cols);
-  if (tempMaxSide > getSizeMaxWindow()) {
-    emit clearLabelVideo(); // We leave the graphic label clean
-    return tempMaxSide;
-  }
+  loadScanMask("image");
 
   command = 3;
   stopped = false;
@@ -226,6 +296,7 @@ void threadDetector::startDetectObjectVideoCamera() {
           stopped = false;
           break;
         }
+        if (trackingChanged) applyTrackingConfig();
       }
 
       cap >> frameTemp;
@@ -247,13 +318,18 @@ void threadDetector::startDetectObjectVideoCamera() {
           stopped = false;
           break;
         }
+        if (trackingChanged) applyTrackingConfig();
       }
 
       cap >> frameTemp;
       cv::flip(frameTemp, frame, 1);
       std::vector < cv::RotatedRect > coordinatesDetectedObjectsRotated; // When the angle is normalized
       std::vector < cv::Mat > listDetectedObjects; // Objects that will be detected
-      objectDetector->detectObjectRectanglesRotatedGrouped(frame, & listDetectedObjects, & coordinatesDetectedObjectsRotated);
+      std::vector < SEARCH_REGION > searchRegions; // Empty when the whole frame is scanned
+      bool tracked = searchRegionsOfFrame(frame, searchRegions);
+      if (!tracked || !searchRegions.empty()) // Nothing moved and there are no tracks, the detector is not called
+        objectDetector->detectObjectRectanglesRotatedGrouped(frame, & listDetectedObjects, & coordinatesDetectedObjectsRotated, true, tracked ? & searchRegions : NULL);
+      updateTracks(coordinatesDetectedObjectsRotated);
 
       emit listCoordinatesAndDetectedObjectsRotated(listDetectedObjects, coordinatesDetectedObjectsRotated);
 
@@ -273,13 +349,18 @@ void threadDetector::startDetectObjectVideoCamera() {
           stopped = false;
           break;
         }
+        if (trackingChanged) applyTrackingConfig();
       }
 
       cap >> frameTemp;
       cv::flip(frameTemp, frame, 1);
       std::vector < cv::Rect > coordinatesDetectedObjects; // When the angle is not normalized
       std::vector < cv::Mat > listDetectedObjects; // Objects that will be detected
-      objectDetector->detectObjectRectanglesGroupedZeroDegrees(frame, & listDetectedObjects, & coordinatesDetectedObjects, doubleList);
+      std::vector < SEARCH_REGION > searchRegions; // Empty when the whole frame is scanned
+      bool tracked = searchRegionsOfFrame(frame, searchRegions);
+      if (!tracked || !searchRegions.empty()) // Nothing moved and there are no tracks, the detector is not called
+        objectDetector->detectObjectRectanglesGroupedZeroDegrees(frame, & listDetectedObjects, & coordinatesDetectedObjects, doubleList, true, tracked ? & searchRegions : NULL);
+      updateTracks(coordinatesDetectedObjects);
 
       emit listCoordinatesAndDetectedObjects(listDetectedObjects, coordinatesDetectedObjects);
 
@@ -326,6 +407,7 @@ void threadDetector::startDetectObjectVideoFile() {
           stopped = false;
           break;
         }
+        if (trackingChanged) applyTrackingConfig();
       }
 
       cap >> frame2;
@@ -353,6 +435,7 @@ void threadDetector::startDetectObjectVideoFile() {
           stopped = false;
           break;
         }
+        if (trackingChanged) applyTrackingConfig();
       }
 
       cap >> frame2;
@@ -366,7 +449,11 @@ void threadDetector::startDetectObjectVideoFile() {
 
       std::vector < cv::RotatedRect > coordinatesDetectedObjectsRotated; // When the angle is normalized
       std::vector < cv::Mat > listDetectedObjects; // Objects that will be detected
-      objectDetector->detectObjectRectanglesRotatedGrouped(frame2, & listDetectedObjects, & coordinatesDetectedObjectsRotated);
+      std::vector < SEARCH_REGION > searchRegions; // Empty when the whole frame is scanned
+      bool tracked = searchRegionsOfFrame(frame2, searchRegions);
+      if (!tracked || !searchRegions.empty())
+        objectDetector->detectObjectRectanglesRotatedGrouped(frame2, & listDetectedObjects, & coordinatesDetectedObjectsRotated, true, tracked ? & searchRegions : NULL);
+      updateTracks(coordinatesDetectedObjectsRotated);
 
       emit listCoordinatesAndDetectedObjectsRotated(listDetectedObjects, coordinatesDetectedObjectsRotated);
 
@@ -387,6 +474,7 @@ void threadDetector::startDetectObjectVideoFile() {
           stopped = false;
           break;
         }
+        if (trackingChanged) applyTrackingConfig();
       }
 
       cap >> frame2;
@@ -400,7 +488,11 @@ void threadDetector::startDetectObjectVideoFile() {
 
       std::vector < cv::Rect > coordinatesDetectedObjects; // When the angle is not normalized
       std::vector < cv::Mat > listDetectedObjects; // Objects that will be detected
-      objectDetector->detectObjectRectanglesGroupedZeroDegrees(frame2, & listDetectedObjects, & coordinatesDetectedObjects, doubleList);
+      std::vector < SEARCH_REGION > searchRegions; // Empty when the whole frame is scanned
+      bool tracked = searchRegionsOfFrame(frame2, searchRegions);
+      if (!tracked || !searchRegions.empty())
+        objectDetector->detectObjectRectanglesGroupedZeroDegrees(frame2, & listDetectedObjects, & coordinatesDetectedObjects, doubleList, true, tracked ? & searchRegions : NULL);
+      updateTracks(coordinatesDetectedObjects);
 
       emit listCoordinatesAndDetectedObjects(listDetectedObjects, coordinatesDetectedObjects);
 
@@ -464,7 +556,7 @@ void threadDetector::startDetectObjectImageFile() {
 
     std::vector < cv::Rect > coordinatesDetectedObjects; // When the angle is not normalized
     std::vector < cv::Mat > listDetectedObjects; // Objects that will be detected
-    objectDetector->detectObjectRectanglesGroupedZeroDegrees(currentImage, & listDetectedObjects, & coordinatesDetectedObjects, doubleList);
+    objectDetector->detectObjectRectanglesTiled(currentImage, & listDetectedObjects, & coordinatesDetectedObjects, doubleList); // Same as the grouped detection if the image fits in a tile
 
     emit listCoordinatesAndDetectedObjects_img(listDetectedObjects, coordinatesDetectedObjects);
 
@@ -493,10 +585,19 @@ void threadDetector::loadDetector(std::string fileName) {
   }
 
   objectDetector = new CASCADE_CLASSIFIERS_EVALUATION(fileName);
+  nameDetector = fileName;
+  objectDetector -> setSizeExtractedObjects(sizeExtractedObjects);
   detectorIsLoad = true;
 
 }
 
+void threadDetector::setSizeExtractedObjects(const cv::Size & size) {
+  QMutexLocker locker( & mutex);
+  sizeExtractedObjects = size;
+  if (objectDetector != NULL)
+    objectDetector -> setSizeExtractedObjects(size);
+}
+
 bool threadDetector::setDevice(int i) {
 
   if (cap.isOpened()) cap.release(); // In case a device was previously open
@@ -677,6 +778,72 @@ GUI_DETECTOR::GUI_DETECTOR(threadDetector * myThreadDetector): myThreadDetector(
   checkBoxFlagExtractColorImages = new QCheckBox("Extract color detections");
   connect(checkBoxFlagExtractColorImages, SIGNAL(stateChanged(int)), this, SLOT(edition()));
 
+  checkBoxFlagParallelScan = new QCheckBox("Parallel scan");
+  connect(checkBoxFlagParallelScan, SIGNAL(stateChanged(int)), this, SLOT(edition()));
+
+  checkBoxFlagPyramid = new QCheckBox("Image pyramid");
+  connect(checkBoxFlagPyramid, SIGNAL(stateChanged(int)), this, SLOT(edition()));
+
+  checkBoxFlagRejectionTraces = new QCheckBox("Rejection traces");
+  connect(checkBoxFlagRejectionTraces, SIGNAL(stateChanged(int)), this, SLOT(edition()));
+
+  checkBoxTrackerGuided = new QCheckBox("Tracker-guided scan");
+  connect(checkBoxTrackerGuided, SIGNAL(stateChanged(int)), this, SLOT(edition()));
+
+  lineEditFramesBetweenFullScans = new QLineEdit;
+  lineEditFramesBetweenFullScans -> setValidator(new QIntValidator(1, 1000));
+  lineEditFramesBetweenFullScans -> setFixedWidth(40);
+  connect(lineEditFramesBetweenFullScans, SIGNAL(textEdited(const QString & )), this, SLOT(edition()));
+
+  checkBoxFlagCoarseToFine = new QCheckBox("Coarse-to-fine scan");
+  connect(checkBoxFlagCoarseToFine, SIGNAL(stateChanged(int)), this, SLOT(edition()));
+
+  lineEditCoarseStep = new QLineEdit;
+  lineEditCoarseStep -> setValidator(new QIntValidator(1, 16));
+  lineEditCoarseStep -> setFixedWidth(40);
+  connect(lineEditCoarseStep, SIGNAL(textEdited(const QString & )), this, SLOT(edition()));
+
+  lineEditCoarseStages = new QLineEdit;
+  lineEditCoarseStages -> setValidator(new QIntValidator(1, 1000));
+  lineEditCoarseStages -> setFixedWidth(40);
+  connect(lineEditCoarseStages, SIGNAL(textEdited(const QString & )), this, SLOT(edition()));
+
+  lineEditRefinementRadius = new QLineEdit;
+  lineEditRefinementRadius -> setValidator(new QIntValidator(0, 16));
+  lineEditRefinementRadius -> setFixedWidth(40);
+  connect(lineEditRefinementRadius, SIGNAL(textEdited(const QString & )), this, SLOT(edition()));
+
+  checkBoxFlagAnglePruning = new QCheckBox("Angle pruning");
+  connect(checkBoxFlagAnglePruning, SIGNAL(stateChanged(int)), this, SLOT(edition()));
+
+  lineEditAnglePruningMargin = new QLineEdit;
+  QRegExp reAnglePruningMargin("([0-9]*[//.][0-9]*)");
+  QRegExpValidator * validatorAnglePruningMargin = new QRegExpValidator(reAnglePruningMargin, this);
+  lineEditAnglePruningMargin -> setValidator(validatorAnglePruningMargin);
+  lineEditAnglePruningMargin -> setFixedWidth(40);
+  connect(lineEditAnglePruningMargin, SIGNAL(textEdited(const QString & )), this, SLOT(edition()));
+
+  checkBoxFlagLargestObject = new QCheckBox("Largest object only");
+  connect(checkBoxFlagLargestObject, SIGNAL(stateChanged(int)), this, SLOT(edition()));
+
+  checkBoxMotionGated = new QCheckBox("Motion-gated scan");
+  connect(checkBoxMotionGated, SIGNAL(stateChanged(int)), this, SLOT(edition()));
+
+  lineEditMotionThreshold = new QLineEdit;
+  lineEditMotionThreshold -> setValidator(new QIntValidator(1, 255));
+  lineEditMotionThreshold -> setFixedWidth(40);
+  connect(lineEditMotionThreshold, SIGNAL(textEdited(const QString & )), this, SLOT(edition()));
+
+  lineEditMinSizeObject = new QLineEdit;
+  lineEditMinSizeObject -> setValidator(new QIntValidator(0, 100000));
+  lineEditMinSizeObject -> setFixedWidth(40);
+  connect(lineEditMinSizeObject, SIGNAL(textEdited(const QString & )), this, SLOT(edition()));
+
+  lineEditMaxSizeObject = new QLineEdit;
+  lineEditMaxSizeObject -> setValidator(new QIntValidator(0, 100000));
+  lineEditMaxSizeObject -> setFixedWidth(40);
+  connect(lineEditMaxSizeObject, SIGNAL(textEdited(const QString & )), this, SLOT(edition()));
+
   //QLabel
   textNumberStrongLearns = new QLabel(QString("<font color=red>MAX strongLearns</font></h2>"));
 
@@ -722,6 +889,30 @@ GUI_DETECTOR::GUI_DETECTOR(threadDetector * myThreadDetector): myThreadDetector(
   layoutExtraSettings -> addWidget(checkBoxNormalizeRotation, 0, 2, 1, 2, Qt::AlignLeft);
   layoutExtraSettings -> addWidget(checkBoxDoubleList, 1, 0, 1, 2, Qt::AlignLeft);
   layoutExtraSettings -> addWidget(checkBoxFlagExtractColorImages, 1, 2, 1, 2, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(checkBoxFlagParallelScan, 5, 0, 1, 2, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(checkBoxFlagPyramid, 5, 2, 1, 2, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(checkBoxFlagRejectionTraces, 6, 0, 1, 2, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(checkBoxTrackerGuided, 6, 2, 1, 2, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(new QLabel(QString::fromUtf8("Full scan every (frames)")), 7, 0, 1, 3, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(lineEditFramesBetweenFullScans, 7, 3, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(checkBoxFlagCoarseToFine, 8, 0, 1, 2, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(new QLabel(QString::fromUtf8("Coarse step")), 8, 2, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(lineEditCoarseStep, 8, 3, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(new QLabel(QString::fromUtf8("Coarse stages")), 9, 0, 1, 1, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(lineEditCoarseStages, 9, 1, 1, 1, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(new QLabel(QString::fromUtf8("Refinement radius")), 9, 2, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(lineEditRefinementRadius, 9, 3, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(checkBoxFlagAnglePruning, 10, 0, 1, 2, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(new QLabel(QString::fromUtf8("Pruning margin")), 10, 2, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(lineEditAnglePruningMargin, 10, 3, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(checkBoxFlagLargestObject, 11, 0, 1, 4, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(new QLabel(QString::fromUtf8("Min size (0 none)")), 12, 0, 1, 1, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(lineEditMinSizeObject, 12, 1, 1, 1, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(new QLabel(QString::fromUtf8("Max size (0 none)")), 12, 2, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(lineEditMaxSizeObject, 12, 3, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(checkBoxMotionGated, 13, 0, 1, 2, Qt::AlignLeft);
+  layoutExtraSettings -> addWidget(new QLabel(QString::fromUtf8("Motion threshold")), 13, 2, 1, 1, Qt::AlignRight);
+  layoutExtraSettings -> addWidget(lineEditMotionThreshold, 13, 3, 1, 1, Qt::AlignRight);
 
   //________________________HSV CONFIGURATION GRAPH PANEL______________________________________//
 
@@ -812,6 +1003,22 @@ void GUI_DETECTOR::setEnabledFalseAllConfig() {
   checkBoxNormalizeRotation -> setEnabled(false);
   checkBoxDoubleList -> setEnabled(false);
   checkBoxFlagExtractColorImages -> setEnabled(false);
+  checkBoxFlagParallelScan -> setEnabled(false);
+  checkBoxFlagPyramid -> setEnabled(false);
+  checkBoxFlagRejectionTraces -> setEnabled(false);
+  checkBoxTrackerGuided -> setEnabled(false);
+  lineEditFramesBetweenFullScans -> setEnabled(false);
+  checkBoxFlagCoarseToFine -> setEnabled(false);
+  lineEditCoarseStep -> setEnabled(false);
+  lineEditCoarseStages -> setEnabled(false);
+  lineEditRefinementRadius -> setEnabled(false);
+  checkBoxFlagAnglePruning -> setEnabled(false);
+  lineEditAnglePruningMargin -> setEnabled(false);
+  checkBoxFlagLargestObject -> setEnabled(false);
+  lineEditMinSizeObject -> setEnabled(false);
+  lineEditMaxSizeObject -> setEnabled(false);
+  checkBoxMotionGated -> setEnabled(false);
+  lineEditMotionThreshold -> setEnabled(false);
 
 }
 
@@ -839,6 +1046,22 @@ void GUI_DETECTOR::setEnabledTrueConfigDefault() {
   checkBoxNormalizeRotation -> setEnabled(true);
   checkBoxDoubleList -> setEnabled(true);
   checkBoxFlagExtractColorImages -> setEnabled(true);
+  checkBoxFlagParallelScan -> setEnabled(true);
+  checkBoxFlagPyramid -> setEnabled(true);
+  checkBoxFlagRejectionTraces -> setEnabled(true);
+  checkBoxTrackerGuided -> setEnabled(true);
+  lineEditFramesBetweenFullScans -> setEnabled(true);
+  checkBoxFlagCoarseToFine -> setEnabled(true);
+  lineEditCoarseStep -> setEnabled(true);
+  lineEditCoarseStages -> setEnabled(true);
+  lineEditRefinementRadius -> setEnabled(true);
+  checkBoxFlagAnglePruning -> setEnabled(true);
+  lineEditAnglePruningMargin -> setEnabled(true);
+  checkBoxFlagLargestObject -> setEnabled(true);
+  lineEditMinSizeObject -> setEnabled(true);
+  lineEditMaxSizeObject -> setEnabled(true);
+  checkBoxMotionGated -> setEnabled(true);
+  lineEditMotionThreshold -> setEnabled(true);
 
 }
 
@@ -867,6 +1090,22 @@ void GUI_DETECTOR::setdefaultConfig() {
   checkBoxNormalizeRotation -> setCheckState(Qt::Unchecked);
   checkBoxDoubleList -> setCheckState(Qt::Checked);
   checkBoxFlagExtractColorImages -> setCheckState(Qt::Checked);
+  checkBoxFlagParallelScan -> setCheckState(Qt::Checked);
+  checkBoxFlagPyramid -> setCheckState(Qt::Unchecked);
+  checkBoxFlagRejectionTraces -> setCheckState(Qt::Unchecked);
+  checkBoxTrackerGuided -> setCheckState(Qt::Unchecked);
+  lineEditFramesBetweenFullScans -> setText("10");
+  checkBoxFlagCoarseToFine -> setCheckState(Qt::Unchecked);
+  lineEditCoarseStep -> setText("2");
+  lineEditCoarseStages -> setText("2");
+  lineEditRefinementRadius -> setText("1");
+  checkBoxFlagAnglePruning -> setCheckState(Qt::Unchecked);
+  lineEditAnglePruningMargin -> setText("1.0");
+  checkBoxFlagLargestObject -> setCheckState(Qt::Unchecked);
+  lineEditMinSizeObject -> setText("0");
+  lineEditMaxSizeObject -> setText("0");
+  checkBoxMotionGated -> setCheckState(Qt::Unchecked);
+  lineEditMotionThreshold -> setText("15");
 
 }
 
@@ -955,7 +1194,7 @@ void GUI_DETECTOR::loadDetector() {
   }
 
   //____Open the dialog to load a file____
-  QString fileName = QFileDialog::getOpenFileName(this, tr("Open detector"), LAST_PATH_DETECTOR, tr("Detector files xml (*.xml)\n"));
+  QString fileName = QFileDialog::getOpenFileName(this, tr("Open detector"), LAST_PATH_DETECTOR, tr("Detector files (*.xml *.bin)\n"));
   if (fileName == "") {
       return; //In case the user does not open anything.
   }else {
@@ -976,7 +1215,10 @@ void GUI_DETECTOR::setConfig() {
   if ((lineEditDegreesDetections->text() == "") || (lineEditSizeMaxWindow->text() == "") || (lineEditSizeBase->text() == "") ||
     (lineEditFactorScaleWindow->text() == "") || (lineEditStepWindow->text() == "") || (lineEditGroupThreshold->text() == "") || 
     (lineEditEps->text() == "") || (lineEditNumberClassifiersUsed->text() == "") || (lineEditLineThicknessRectangles->text() == "") || 
-    (lineEditColorRectanglesR->text() == "") || (lineEditColorRectanglesG->text() == "") || (lineEditColorRectanglesB->text() == "")) {
+    (lineEditColorRectanglesR->text() == "") || (lineEditColorRectanglesG->text() == "") || (lineEditColorRectanglesB->text() == "") ||
+    (lineEditFramesBetweenFullScans->text() == "") || (lineEditCoarseStep->text() == "") || (lineEditCoarseStages->text() == "") ||
+    (lineEditRefinementRadius->text() == "") || (lineEditAnglePruningMargin->text() == "") || (lineEditMinSizeObject->text() == "") ||
+    (lineEditMaxSizeObject->text() == "") || (lineEditMotionThreshold->text() == "")) {
     QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Some fields are missing."), QMessageBox::Ok);
     return;
   }
@@ -1040,6 +1282,14 @@ void GUI_DETECTOR::setConfig() {
   bool normalizeRotation = false;
   bool doubleList = false;
   bool flagExtractColorImages = false;
+  bool flagParallelScan = false;
+  bool flagPyramid = false;
+  bool flagRejectionTraces = false;
+  bool trackerGuided = false;
+  bool flagCoarseToFine = false;
+  bool flagAnglePruning = false;
+  bool flagLargestObject = false;
+  bool motionGated = false;
 
   if (checkBoxFlagActivateSkinColor->checkState() == Qt::Checked)
     flagActivateSkinColor = true;
@@ -1049,6 +1299,22 @@ void GUI_DETECTOR::setConfig() {
     doubleList = true;
   if (checkBoxFlagExtractColorImages->checkState() == Qt::Checked)
     flagExtractColorImages = true;
+  if (checkBoxFlagParallelScan->checkState() == Qt::Checked)
+    flagParallelScan = true;
+  if (checkBoxFlagPyramid->checkState() == Qt::Checked)
+    flagPyramid = true;
+  if (checkBoxFlagRejectionTraces->checkState() == Qt::Checked)
+    flagRejectionTraces = true;
+  if (checkBoxTrackerGuided->checkState() == Qt::Checked)
+    trackerGuided = true;
+  if (checkBoxFlagCoarseToFine->checkState() == Qt::Checked)
+    flagCoarseToFine = true;
+  if (checkBoxFlagAnglePruning->checkState() == Qt::Checked)
+    flagAnglePruning = true;
+  if (checkBoxFlagLargestObject->checkState() == Qt::Checked)
+    flagLargestObject = true;
+  if (checkBoxMotionGated->checkState() == Qt::Checked)
+    motionGated = true;
 
   myThreadDetector->objectDetector->setDegreesDetections(degreesDetection);
 
@@ -1057,6 +1323,7 @@ void GUI_DETECTOR::setConfig() {
 
   myThreadDetector->objectDetector->setFactorScaleWindow(factorScaleWindow);
   myThreadDetector->objectDetector->setStepWindow(stepWindow);
+  myThreadDetector->objectDetector->setFlagPyramid(flagPyramid);
 
   myThreadDetector->objectDetector->setGroupThreshold(groupThreshold);
   myThreadDetector->objectDetector->setEps(eps);
@@ -1083,8 +1350,19 @@ void GUI_DETECTOR::setConfig() {
 
   myThreadDetector->normalizeRotation = normalizeRotation;
   myThreadDetector->doubleList = doubleList;
+  myThreadDetector->setTrackingConfig(trackerGuided, motionGated, lineEditFramesBetweenFullScans->text().toInt(), lineEditMotionThreshold->text().toInt());
 
   myThreadDetector->objectDetector->setFlagExtractColorImages(flagExtractColorImages);
+  myThreadDetector->objectDetector->setFlagParallelScan(flagParallelScan);
+  myThreadDetector->objectDetector->setFlagRejectionTraces(flagRejectionTraces);
+  myThreadDetector->objectDetector->setFlagCoarseToFine(flagCoarseToFine);
+  myThreadDetector->objectDetector->setCoarseStep(lineEditCoarseStep->text().toInt());
+  myThreadDetector->objectDetector->setCoarseStages(lineEditCoarseStages->text().toInt());
+  myThreadDetector->objectDetector->setRefinementRadius(lineEditRefinementRadius->text().toInt());
+  myThreadDetector->objectDetector->setFlagAnglePruning(flagAnglePruning);
+  myThreadDetector->objectDetector->setAnglePruningMargin(lineEditAnglePruningMargin->text().toDouble());
+  myThreadDetector->objectDetector->setFlagLargestObject(flagLargestObject);
+  myThreadDetector->objectDetector->setSizeLimitsObject(lineEditMinSizeObject->text().toInt(), lineEditMaxSizeObject->text().toInt());
 
   myThreadDetector->objectDetector->initializeFeatures();
 
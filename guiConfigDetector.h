@@ -52,6 +52,8 @@ class QGroupBox;
 
 //Forward custom classes
 class CASCADE_CLASSIFIERS_EVALUATION;
+class SEARCH_REGION;
+class MOTION_MAP;
 class GUI_DETECTOR;
 
 class threadDetector: public QThread {
@@ -76,14 +78,38 @@ class threadDetector: public QThread {
   //std::vector<cv::Rect> coordinatesDetectedObjects; //When the angle is not normalized
 
   cv::Mat currentImage; //Image to detect
+  cv::Size sizeExtractedObjects; //Size of the rotated detections sent to the recognizer, empty while the recognition is not enabled
 
   CASCADE_CLASSIFIERS_EVALUATION * objectDetector;
+  std::string nameDetector; //File of the loaded cascade, the scan masks of the streams are next to it
 
   //Flags
   bool detectorIsLoad;
   bool normalizeRotation;
   bool doubleList;
   bool groupingRectangles;
+  bool trackerGuided;
+  bool motionGated;
+
+  //Tracker-guided scan (only camera and video with grouped rectangles)
+  int framesBetweenFullScans; //Every this number of frames the whole frame is scanned, to find new objects
+  int framesSinceFullScan;
+  std::vector < cv::Rect > tracks; //Objects detected in the previous frame
+  MOTION_MAP * motionMap; //Motion-gated scan (same streams as the tracker-guided one), only the regions that moved and those of the tracks are scanned
+  /*Regions around the tracks and, with motionGated, around the moving blocks of frame. False when the frame must be scanned completely, an empty
+  list when nothing has to be scanned*/
+  bool searchRegionsOfFrame(const cv::Mat & frame, std::vector < SEARCH_REGION > & searchRegions);
+  void updateTracks(const std::vector < cv::Rect > & coordinatesDetectedObjects);
+  void updateTracks(const std::vector < cv::RotatedRect > & coordinatesDetectedObjectsRotated);
+  void loadScanMask(const std::string & nameStream); //Applies <cascade file>.<nameStream>.xml, or <cascade file>.mask.xml if the stream has none (see SCAN_MASK)
+  /*Configuration of the tracker-guided and motion-gated scan given by setTrackingConfig, the detection thread applies it with mutex locked
+  before its next frame, so the tracks and the motion map are only touched by that thread while it runs*/
+  bool trackingChanged;
+  bool pendingTrackerGuided;
+  bool pendingMotionGated;
+  int pendingFramesBetweenFullScans;
+  int pendingMotionThreshold;
+  void applyTrackingConfig(); //Called with mutex locked, it also clears the tracks and the motion map
 
   public:
     threadDetector();
@@ -93,6 +119,8 @@ class threadDetector: public QThread {
   void loadDetector(std::string fileName);
   bool setDevice(int i); //For camera
   bool setDevice(std::string videoFile); //For video file
+  void setSizeExtractedObjects(const cv::Size & size); //The rotated detections are sampled directly at this size (see CASCADE_CLASSIFIERS_EVALUATION::setSizeExtractedObjects)
+  void setTrackingConfig(bool trackerGuided, bool motionGated, int framesBetweenFullScans, int motionThreshold); //Applied from the next frame
 
   //Command functions for run
   int detectObjectVideoCamera(int device);
@@ -174,11 +202,34 @@ class GUI_DETECTOR: public QDialog {
   QLineEdit * lineEditVmin;
   QLineEdit * lineEditVmax;
 
+  QLineEdit * lineEditFramesBetweenFullScans;
+
+  //For the coarse-to-fine scan
+  QLineEdit * lineEditCoarseStep;
+  QLineEdit * lineEditCoarseStages;
+  QLineEdit * lineEditRefinementRadius;
+
+  QLineEdit * lineEditAnglePruningMargin;
+
+  //For the largest object mode
+  QLineEdit * lineEditMinSizeObject;
+  QLineEdit * lineEditMaxSizeObject;
+
+  QLineEdit * lineEditMotionThreshold;
+
   //QCheckBox
   QCheckBox * checkBoxFlagActivateSkinColor;
   QCheckBox * checkBoxNormalizeRotation;
   QCheckBox * checkBoxDoubleList;
   QCheckBox * checkBoxFlagExtractColorImages;
+  QCheckBox * checkBoxFlagParallelScan;
+  QCheckBox * checkBoxFlagPyramid;
+  QCheckBox * checkBoxFlagRejectionTraces;
+  QCheckBox * checkBoxTrackerGuided;
+  QCheckBox * checkBoxFlagCoarseToFine;
+  QCheckBox * checkBoxFlagAnglePruning;
+  QCheckBox * checkBoxFlagLargestObject;
+  QCheckBox * checkBoxMotionGated;
 
   //QLabel
   QLabel * textNumberStrongLearns;
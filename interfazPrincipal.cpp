@@ -829,6 +829,9 @@ void interfaz::enableActionRecognition(bool flag) {
 void interfaz::enableRecognition(bool flag) {
 
   if (enableRecognitionAction -> isChecked()) {
+    /*The rotated detections are sampled once at the size of the recognizer images, instead of being resized again by the recognizer*/
+    detector -> setSizeExtractedObjects(cv::Size(facialRecognizer -> get_newWidthImages(), facialRecognizer -> get_newHighImages()));
+
     connect(detector, SIGNAL(listCoordinatesAndDetectedObjects(std::vector < cv::Mat > , std::vector < cv::Rect > )), & myTrackerWindows, SLOT(newGroupDetections(std::vector < cv::Mat > , std::vector < cv::Rect > )), Qt::QueuedConnection);
     connect(detector, SIGNAL(listCoordinatesAndDetectedObjectsRotated(std::vector < cv::Mat > , std::vector < cv::RotatedRect > )), & myTrackerWindows, SLOT(newGroupDetections(std::vector < cv::Mat > , std::vector < cv::RotatedRect > )), Qt::QueuedConnection);
 
@@ -837,6 +840,8 @@ void interfaz::enableRecognition(bool flag) {
 
   } else {
 
+    detector -> setSizeExtractedObjects(cv::Size());
+
     disconnect(detector, SIGNAL(listCoordinatesAndDetectedObjects(std::vector < cv::Mat > , std::vector < cv::Rect > )), & myTrackerWindows, SLOT(newGroupDetections(std::vector < cv::Mat > , std::vector < cv::Rect > )));
     disconnect(detector, SIGNAL(listCoordinatesAndDetectedObjectsRotated(std::vector < cv::Mat > , std::vector < cv::RotatedRect > )), & myTrackerWindows, SLOT(newGroupDetections(std::vector < cv::Mat > , std::vector < cv::RotatedRect > )));
 
@@ -882,14 +887,8 @@ void interfaz::captureVideo() {
 
     int tempReturn = detector -> detectObjectVideoCamera(lineEditDevice -> text().toInt());
     if (tempReturn != -1) {
-      /*In case the device opening fails or if the frames produced by the device exceed the maximum search window size*/
-
-      if (tempReturn == 0) {
-        QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not open the device ") + lineEditDevice -> text(), QMessageBox::Ok);
-      } else {
-        QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not analyze the frames of the device ") + lineEditDevice -> text() + QString::fromUtf8(" because its largest side measures ") + QString::number(tempReturn) + QString::fromUtf8(" pixels and the maximum search window size is ") + QString::number(detector -> getSizeMaxWindow()) + QString::fromUtf8(" pixels, please set a size equal to or greater than the search window size and try again "), QMessageBox::Ok);
-      }
-
+      /*In case the device opening fails*/
+      QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not open the device ") + lineEditDevice -> text(), QMessageBox::Ok);
     } else {
       listImages -> setFlagDetectorIsActive(true);
     }
@@ -1153,14 +1152,8 @@ void interfaz::currentFile() {
     int tempReturn = detector -> detectObjectVideoFile(tempNameFile.toStdString());
 
     if (tempReturn != -1) {
-      /* In case the device cannot be opened or if the frames produced by the device are larger than the maximum window size */
-
-      if (tempReturn == 0) {
-        QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not open the video ") + tempNameFile, QMessageBox::Ok);
-      } else {
-        QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not analyze the frames of the video ") + tempNameFile + QString::fromUtf8(" because its largest side is ") + QString::number(tempReturn) + QString::fromUtf8(" pixels and the maximum window size is ") + QString::number(detector -> getSizeMaxWindow()) + QString::fromUtf8(" pixels, please set a size equal to or larger for the search window and try again"), QMessageBox::Ok);
-      }
-
+      /* In case the video cannot be opened */
+      QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not open the video ") + tempNameFile, QMessageBox::Ok);
     } else {
       listImages -> setFlagDetectorIsActive(true);
     }
@@ -1171,14 +1164,8 @@ void interfaz::currentFile() {
     int tempReturn = detector -> detectObjectImageFile(tempNameFile.toStdString());
 
     if (tempReturn != -1) {
-      /* In case the device cannot be opened or if the frames produced by the device are larger than the maximum window size */
-
-      if (tempReturn == 0) {
-        QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not open the image ") + tempNameFile, QMessageBox::Ok);
-      } else {
-        QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not analyze the frames of the image ") + tempNameFile + QString::fromUtf8(" because its largest side is ") + QString::number(tempReturn) + QString::fromUtf8(" pixels and the maximum window size is ") + QString::number(detector -> getSizeMaxWindow()) + QString::fromUtf8(" pixels, please set a size equal to or larger for the search window and try again"), QMessageBox::Ok);
-      }
-
+      /* In case the image cannot be opened */
+      QMessageBox::warning(this, tr("WARNING"), QString::fromUtf8("Could not open the image ") + tempNameFile, QMessageBox::Ok);
     } else {
       listImages -> setFlagDetectorIsActive(true);
     }
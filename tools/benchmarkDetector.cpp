@@ -0,0 +1,328 @@
+/***************************************************************************
+**                                                                        **
+**  This source code is part of UVface++, a system developed by           **
+**  Roger Figueroa Quintero as part of his undergraduate thesis titled:   **
+**  "Image Analysis System for Face Detection and Recognition"            **
+**  at Universidad del Valle, Cali, Colombia.                             **
+**                                                                        **
+**  Copyright (C) 2016-2024 Roger Figueroa Quintero                       **
+**                                                                        **
+**  This software is licensed for non-commercial use only. Redistribution **
+**  and use in source and binary forms, with or without modification, are **
+**  permitted provided that the following conditions are met:             **
+**                                                                        **
+**  1. Redistributions of source code must retain the above copyright     **
+**     notice, this list of conditions, and the following disclaimer.     **
+**  2. Redistributions in binary form must reproduce the above copyright  **
+**     notice, this list of conditions, and the following disclaimer in   **
+**     the documentation and/or other materials provided with the         **
+**     distribution.                                                      **
+**  3. The name of the author may not be used to endorse or promote       **
+**     products derived from this software without specific prior written **
+**     permission.                                                        **
+**  4. This software is to be used for non-commercial purposes only.      **
+**                                                                        **
+**  This software is distributed in the hope that it will be useful, but  **
+**  WITHOUT ANY WARRANTY; without even the implied warranty of            **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                  **
+**                                                                        **
+****************************************************************************
+**           Author: Roger Figueroa Quintero                              **
+**  Contact Email: roggerfq@hotmail.com                                   **
+**          Date: First developed: November 2016                          **
+**                Last modified: December 2024                            **
+****************************************************************************/
+
+
+
+/*
+Replays a directory of frames through each detection function of CASCADE_CLASSIFIERS_EVALUATION, without the GUI, and prints for each one
+the frames per second, the windows per second, the nanoseconds per window, the trees per window, the time of the scan against the time of
+the grouping, the time of each scale and the survival curve of the stages (see SCAN_STATISTICS):
+
+  benchmarkDetector cascade.xml frames/
+  benchmarkDetector cascade.xml frames/ -repeat 5 -engine 1 -degrees -20,0,20
+  benchmarkDetector frontal.xml frames/ -models profile.xml -function 4
+
+The frames are read once before the measurements and each function runs first on all of them without measuring, so the buffers of the
+context are already allocated. The scan uses the threads of flagParallelScan unless -serial is given.
+*/
+
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include "detector.h"
+
+#if !defined(UVFACE_SCAN_STATISTICS)
+#error "benchmarkDetector needs UVFACE_SCAN_STATISTICS (see CMakeLists.txt)"
+#endif
+
+static bool isImageFile(std::string name) {
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  const char * extensions[] = {".jpg", ".jpeg", ".png", ".bmp", ".pgm", ".ppm"};
+  for (int k = 0; k < 6; k++) {
+    std::string extension(extensions[k]);
+    if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0) return true;
+  }
+  return false;
+}
+
+/*Detection functions that are measured*/
+enum BENCHMARK_FUNCTION {
+  BENCHMARK_UNGROUPED = 0,
+  BENCHMARK_GROUPED_ZERO_DEGREES = 1,
+  BENCHMARK_ROTATED_GROUPED = 2,
+  BENCHMARK_FDDB = 3,
+  BENCHMARK_MULTI_MODEL = 4,
+  BENCHMARK_TILED = 5,
+  BENCHMARK_LUMA = 6,
+  NUMBER_BENCHMARK_FUNCTIONS = 7
+};
+
+static const char * nameFunction(int function) {
+  const char * names[] = {"detectObjectRectanglesUngrouped", "detectObjectRectanglesGroupedZeroDegrees", "detectObjectRectanglesRotatedGrouped", "FDDB_detectObjectRectanglesGroupedZeroDegrees", "detectObjectRectanglesMultiModel", "detectObjectRectanglesTiled", "detectObjectRectanglesLuma"};
+  return names[function];
+}
+
+static void runFunction(const CASCADE_CLASSIFIERS_EVALUATION & detector, const std::vector < const CASCADE_CLASSIFIERS_EVALUATION * > & models, DETECTION_CONTEXT & context, int function, cv::Mat & frame) {
+
+  std::vector < cv::Rect > rectangles;
+  std::vector < int > modelIds;
+  std::vector < cv::RotatedRect > rotatedRectangles;
+  std::vector < double > scores;
+
+  switch (function) {
+  case BENCHMARK_UNGROUPED:
+    detector.detectObjectRectanglesUngrouped(context, frame);
+    break;
+  case BENCHMARK_GROUPED_ZERO_DEGREES:
+    detector.detectObjectRectanglesGroupedZeroDegrees(context, frame, NULL, & rectangles, true, false);
+    break;
+  case BENCHMARK_ROTATED_GROUPED:
+    detector.detectObjectRectanglesRotatedGrouped(context, frame, NULL, & rotatedRectangles, false);
+    break;
+  case BENCHMARK_FDDB:
+    #if EVALUATION_FDDB == 1
+    detector.FDDB_detectObjectRectanglesGroupedZeroDegrees(context, frame, rectangles, scores, true);
+    #endif
+    break;
+  case BENCHMARK_MULTI_MODEL:
+    detector.detectObjectRectanglesMultiModel(context, frame, models, rectangles, modelIds, true, false);
+    break;
+  case BENCHMARK_TILED:
+    detector.detectObjectRectanglesTiled(context, frame, NULL, & rectangles, true, false);
+    break;
+  case BENCHMARK_LUMA: // The frame is the luma plane, see main
+    detector.detectObjectRectanglesLuma(context, frame.ptr < uchar > (), frame.cols, frame.rows, frame.step, true, rectangles);
+    break;
+  }
+
+}
+
+static void report(const SCAN_STATISTICS & statistics, int numberFrames, double seconds, int numberStages) {
+
+  std::cout << "Frames per second: " << numberFrames / seconds << " (" << numberFrames << " frames in " << seconds << " s)\n";
+  if (statistics.windows == 0) return;
+
+  std::cout << "Windows per second: " << statistics.windows / seconds << " (" << statistics.windows << " windows)\n";
+  std::cout << "Nanoseconds per window: " << 1e9 * statistics.secondsScan / statistics.windows << "\n";
+  std::cout << "Trees per window: " << double(statistics.trees) / statistics.windows << "\n";
+  std::cout << "Scan: " << 1e3 * statistics.secondsScan / numberFrames << " ms per frame, grouping: " << 1e3 * statistics.secondsGrouping / numberFrames << " ms per frame\n";
+
+  std::cout << "Scale\tWindows\tms per frame\n";
+  for (int s = 0; s < statistics.windowsByScale.size(); s++)
+    std::cout << s << "\t" << statistics.windowsByScale[s] << "\t" << 1e3 * statistics.secondsByScale[s] / numberFrames << "\n";
+
+  std::cout << "Stage\tEntering\tLeaving\tSurvival\n";
+  for (int s = 0; s < numberStages && statistics.getWindowsEntering(s) > 0; s++)
+    std::cout << s << "\t" << statistics.getWindowsEntering(s) << "\t" << statistics.rejectedByStage[s] << "\t" << 100.0 * statistics.getWindowsEntering(s + 1) / statistics.getWindowsEntering(0) << " %\n";
+  std::cout << "Windows that passed the cascade: " << statistics.getWindowsEntering(numberStages) << "\n";
+
+}
+
+int main(int argc, char * argv[]) {
+
+  if (argc < 3) {
+    std::cout << "Usage: " << argv[0] << " <cascade file> <directory> [options]\n";
+    std::cout << "  -repeat <n>         Times each function goes over the frames (by default 1)\n";
+    std::cout << "  -function <n>       Only measures one function: 0 ungrouped, 1 grouped at zero degrees, 2 rotated and grouped, 3 FDDB, 4 multi-model, 5 tiled, 6 luma plane (mirrored)\n";
+    std::cout << "  -models <list>      Other cascades of the multi-model function separated by commas (without it, it only has the first one)\n";
+    std::cout << "  -engine <n>         One of EVALUATION_ENGINE (0 depth-first, 1 breadth-first)\n";
+    std::cout << "  -degrees <list>     Degrees of the search separated by commas, for example -20,0,20\n";
+    std::cout << "  -sizeBase <n>       Smallest side of the search window\n";
+    std::cout << "  -factorScale <f>    Factor between consecutive scales\n";
+    std::cout << "  -step <f>           Step of the window, relative to its side\n";
+    std::cout << "  -pyramid            Scans an image pyramid instead of scaling the features\n";
+    std::cout << "  -coarseToFine       Scans a coarse grid first\n";
+    std::cout << "  -skin               Activates the skin color filter\n";
+    std::cout << "  -largest            Only the largest object (see flagLargestObject)\n";
+    std::cout << "  -mask <file>        Scan mask of the camera of the frames (see SCAN_MASK)\n";
+    std::cout << "  -tile <n>           Side of the tiles of the tiled function\n";
+    std::cout << "  -serial             Scans each frame in a single thread\n";
+    return 1;
+  }
+
+  std::string nameCascade = argv[1];
+  std::string input = argv[2];
+
+  //____________________Options____________________//
+  int repeat = 1;
+  int onlyFunction = -1;
+  int engine = EVALUATION_ENGINE_DEPTH_FIRST;
+  std::vector < double > degrees;
+  int sizeBase = -1;
+  double factorScale = -1;
+  double step = -1;
+  int sizeTile = -1;
+  bool pyramid = false;
+  bool coarseToFine = false;
+  bool skin = false;
+  bool largest = false;
+  SCAN_MASK scanMask;
+  std::vector < std::string > namesModels;
+  bool serial = false;
+
+  for (int k = 3; k < argc; k++) {
+    std::string option = argv[k];
+    bool hasValue = (k + 1 < argc);
+    if (option == "-repeat" && hasValue) repeat = std::max(1, std::atoi(argv[++k]));
+    else if (option == "-function" && hasValue) onlyFunction = std::atoi(argv[++k]);
+    else if (option == "-engine" && hasValue) engine = std::atoi(argv[++k]);
+    else if (option == "-degrees" && hasValue) {
+      std::istringstream list(argv[++k]);
+      std::string degree;
+      while (std::getline(list, degree, ','))
+        if (!degree.empty()) degrees.push_back(std::atof(degree.c_str()));
+    }
+    else if (option == "-sizeBase" && hasValue) sizeBase = std::atoi(argv[++k]);
+    else if (option == "-factorScale" && hasValue) factorScale = std::atof(argv[++k]);
+    else if (option == "-step" && hasValue) step = std::atof(argv[++k]);
+    else if (option == "-tile" && hasValue) sizeTile = std::atoi(argv[++k]);
+    else if (option == "-pyramid") pyramid = true;
+    else if (option == "-coarseToFine") coarseToFine = true;
+    else if (option == "-skin") skin = true;
+    else if (option == "-largest") largest = true;
+    else if (option == "-mask" && hasValue) {
+      std::string nameMask = argv[++k];
+      if (!scanMask.load(nameMask)) {
+        std::cout << "The scan mask " << nameMask << " could not be read\n";
+        return 1;
+      }
+    }
+    else if (option == "-models" && hasValue) {
+      std::istringstream list(argv[++k]);
+      std::string nameModel;
+      while (std::getline(list, nameModel, ','))
+        if (!nameModel.empty()) namesModels.push_back(nameModel);
+    }
+    else if (option == "-serial") serial = true;
+    else {
+      std::cout << "Unknown option " << option << "\n";
+      return 1;
+    }
+  }
+  //_______________________________________________//
+
+  //____________________Frames____________________//
+  std::vector < std::string > names;
+  DIR * directory = opendir(input.c_str());
+  if (directory == NULL) {
+    std::cout << "The directory " << input << " could not be opened\n";
+    return 1;
+  }
+  for (struct dirent * entry = readdir(directory); entry != NULL; entry = readdir(directory))
+    if (isImageFile(entry -> d_name)) names.push_back(entry -> d_name);
+  closedir(directory);
+  std::sort(names.begin(), names.end());
+
+  std::vector < cv::Mat > frames;
+  for (int k = 0; k < names.size(); k++) {
+    cv::Mat frame = cv::imread(input + "/" + names[k], 1);
+    if (!frame.empty()) frames.push_back(frame);
+  }
+
+  if (frames.empty()) {
+    std::cout << "There are no images in " << input << "\n";
+    return 1;
+  }
+  //______________________________________________//
+
+  //____________________Detector____________________//
+  CASCADE_CLASSIFIERS_EVALUATION detector(nameCascade);
+  if (detector.getNumberStrongLearns() == 0) {
+    std::cout << "No strong classifier was read from " << nameCascade << "\n";
+    return 1;
+  }
+  if (!degrees.empty()) detector.setDegreesDetections(degrees);
+  if (sizeBase > 0) detector.setSizeBase(sizeBase);
+  if (factorScale > 1) detector.setFactorScaleWindow(factorScale);
+  if (step > 0) detector.setStepWindow(step);
+  if (sizeTile > 0) detector.setSizeTile(sizeTile);
+  detector.setFlagPyramid(pyramid);
+  detector.setEvaluationEngine(engine);
+  detector.setFlagCoarseToFine(coarseToFine);
+  detector.setFlagActivateSkinColor(skin);
+  detector.setFlagLargestObject(largest);
+  detector.setFlagParallelScan(!serial);
+  detector.initializeFeatures();
+
+  /*Only the stages of the other models are used, their scan parameters are those of the detector*/
+  std::vector < CASCADE_CLASSIFIERS_EVALUATION * > others;
+  std::vector < const CASCADE_CLASSIFIERS_EVALUATION * > models;
+  for (int k = 0; k < namesModels.size(); k++) {
+    others.push_back(new CASCADE_CLASSIFIERS_EVALUATION(namesModels[k]));
+    if (others.back() -> getNumberStrongLearns() == 0) {
+      std::cout << "No strong classifier was read from " << namesModels[k] << "\n";
+      return 1;
+    }
+    if (!detector.hasSameWindows( * others.back()))
+      std::cout << "The windows of " << namesModels[k] << " do not have the size of those of " << nameCascade << ", it is ignored\n";
+    models.push_back(others.back());
+  }
+  //________________________________________________//
+
+  for (int function = 0; function < NUMBER_BENCHMARK_FUNCTIONS; function++) {
+
+    if (onlyFunction >= 0 && function != onlyFunction) continue;
+    #if EVALUATION_FDDB == 0
+    if (function == BENCHMARK_FDDB) continue;
+    #endif
+
+    DETECTION_CONTEXT context;
+    context.setScanMask(scanMask);
+    std::vector < cv::Mat > copies(frames.size()); // The functions draw on the frames, each run gets a copy made before the measurement
+
+    /*The luma function gets the gray frames, as a camera would give its Y plane*/
+    std::vector < cv::Mat > inputs(frames.size());
+    for (int k = 0; k < frames.size(); k++) {
+      if (function == BENCHMARK_LUMA) cv::cvtColor(frames[k], inputs[k], CV_BGR2GRAY);
+      else inputs[k] = frames[k];
+    }
+
+    for (int k = 0; k < frames.size(); k++) { // Warm-up
+      inputs[k].copyTo(copies[k]);
+      runFunction(detector, models, context, function, copies[k]);
+    }
+    context.clearScanStatistics();
+
+    double seconds = 0;
+    for (int r = 0; r < repeat; r++) {
+      for (int k = 0; k < frames.size(); k++)
+        inputs[k].copyTo(copies[k]);
+      double start = cv::getTickCount();
+      for (int k = 0; k < frames.size(); k++)
+        runFunction(detector, models, context, function, copies[k]);
+      seconds = seconds + (cv::getTickCount() - start) / cv::getTickFrequency();
+    }
+
+    std::cout << "\n____________" << nameFunction(function) << "____________\n";
+    report(context.getScanStatistics(), repeat * frames.size(), seconds, detector.getNumberStrongLearns());
+
+  }
+
+  for (int k = 0; k < others.size(); k++)
+    delete others[k];
+
+  return 0;
+}
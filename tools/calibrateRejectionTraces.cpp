@@ -0,0 +1,95 @@
+/***************************************************************************
+**                                                                        **
+**  This source code is part of UVface++, a system developed by           **
+**  Roger Figueroa Quintero as part of his undergraduate thesis titled:   **
+**  "Image Analysis System for Face Detection and Recognition"            **
+**  at Universidad del Valle, Cali, Colombia.                             **
+**                                                                        **
+**  Copyright (C) 2016-2024 Roger Figueroa Quintero                       **
+**                                                                        **
+**  This software is licensed for non-commercial use only. Redistribution **
+**  and use in source and binary forms, with or without modification, are **
+**  permitted provided that the following conditions are met:             **
+**                                                                        **
+**  1. Redistributions of source code must retain the above copyright     **
+**     notice, this list of conditions, and the following disclaimer.     **
+**  2. Redistributions in binary form must reproduce the above copyright  **
+**     notice, this list of conditions, and the following disclaimer in   **
+**     the documentation and/or other materials provided with the         **
+**     distribution.                                                      **
+**  3. The name of the author may not be used to endorse or promote       **
+**     products derived from this software without specific prior written **
+**     permission.                                                        **
+**  4. This software is to be used for non-commercial purposes only.      **
+**                                                                        **
+**  This software is distributed in the hope that it will be useful, but  **
+**  WITHOUT ANY WARRANTY; without even the implied warranty of            **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                  **
+**                                                                        **
+****************************************************************************
+**           Author: Roger Figueroa Quintero                              **
+**  Contact Email: roggerfq@hotmail.com                                   **
+**          Date: First developed: November 2016                          **
+**                Last modified: December 2024                            **
+****************************************************************************/
+
+
+/*
+Calibrates the rejection traces of a cascade (see CASCADE_CLASSIFIERS_EVALUATION::calibrateRejectionTraces) from a set of positive
+windows, i.e. crops of faces. The images are listed in a text file, one path per line. By default the traces are written next to the
+cascade, where the detector looks for them:
+
+  calibrateRejectionTraces cascade.xml positives.txt [traces file]
+*/
+
+#include <fstream>
+#include "detector.h"
+
+int main(int argc, char * argv[]) {
+
+  if (argc != 3 && argc != 4) {
+    std::cout << "Usage: " << argv[0] << " <cascade file> <list of positive images> [traces file]\n";
+    return 1;
+  }
+
+  std::string nameCascade = argv[1];
+  std::string nameTraces = (argc == 4) ? argv[3] : nameCascade + ".traces.xml";
+
+  CASCADE_CLASSIFIERS_EVALUATION cascade(nameCascade);
+  if (cascade.getNumberStrongLearns() == 0) {
+    std::cout << "No strong classifier was read from " << nameCascade << "\n";
+    return 1;
+  }
+
+  std::ifstream list(argv[2]);
+  if (!list) {
+    std::cout << "The file " << argv[2] << " could not be opened\n";
+    return 1;
+  }
+
+  std::vector < cv::Mat > positives;
+  std::string namePositive;
+  while (std::getline(list, namePositive)) {
+    if (namePositive.empty()) continue;
+    cv::Mat positive = cv::imread(namePositive, 0);
+    if (positive.empty()) {
+      std::cout << "The image " << namePositive << " could not be read\n";
+      continue;
+    }
+    positives.push_back(positive);
+  }
+
+  if (!cascade.calibrateRejectionTraces(positives)) {
+    std::cout << "The rejection traces could not be calibrated\n";
+    return 1;
+  }
+
+  if (!cascade.saveRejectionTraces(nameTraces)) {
+    std::cout << "The file " << nameTraces << " could not be written\n";
+    return 1;
+  }
+
+  std::cout << "Rejection traces written to " << nameTraces << "\n";
+
+  return 0;
+}
@@ -0,0 +1,205 @@
+/***************************************************************************
+**                                                                        **
+**  This source code is part of UVface++, a system developed by           **
+**  Roger Figueroa Quintero as part of his undergraduate thesis titled:   **
+**  "Image Analysis System for Face Detection and Recognition"            **
+**  at Universidad del Valle, Cali, Colombia.                             **
+**                                                                        **
+**  Copyright (C) 2016-2024 Roger Figueroa Quintero                       **
+**                                                                        **
+**  This software is licensed for non-commercial use only. Redistribution **
+**  and use in source and binary forms, with or without modification, are **
+**  permitted provided that the following conditions are met:             **
+**                                                                        **
+**  1. Redistributions of source code must retain the above copyright     **
+**     notice, this list of conditions, and the following disclaimer.     **
+**  2. Redistributions in binary form must reproduce the above copyright  **
+**     notice, this list of conditions, and the following disclaimer in   **
+**     the documentation and/or other materials provided with the         **
+**     distribution.                                                      **
+**  3. The name of the author may not be used to endorse or promote       **
+**     products derived from this software without specific prior written **
+**     permission.                                                        **
+**  4. This software is to be used for non-commercial purposes only.      **
+**                                                                        **
+**  This software is distributed in the hope that it will be useful, but  **
+**  WITHOUT ANY WARRANTY; without even the implied warranty of            **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                  **
+**                                                                        **
+****************************************************************************
+**           Author: Roger Figueroa Quintero                              **
+**  Contact Email: roggerfq@hotmail.com                                   **
+**          Date: First developed: November 2016                          **
+**                Last modified: December 2024                            **
+****************************************************************************/
+
+
+
+/*
+Checks of the detector that need a real cascade and a real image, the image should contain some objects:
+
+  checkDetector cascade.xml image.jpg
+
+Prints one line per check and returns 1 if any of them failed.
+
+- The coarse-to-fine scan with a coarse step of 1 evaluates every window of the normal grid, so it must find exactly the windows of the
+  normal scan, also when the search region has a grid origin (the tiles of detectObjectRectanglesTiled). With a larger coarse step it must
+  find a subset of them
+- The cascade saved in the binary format loads with the same stages and finds the same windows, while a truncated copy of the file and
+  copies with an index out of its array are rejected (the cascade is left without strong classifiers)
+*/
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include "detector.h"
+
+static bool isSubset(const std::vector < cv::Rect > & subset, const std::vector < cv::Rect > & set) {
+  for (int k = 0; k < subset.size(); k++)
+    if (std::find(set.begin(), set.end(), subset[k]) == set.end()) return false;
+  return true;
+}
+
+static bool report(const std::string & name, bool passed) {
+  std::cout << (passed ? "PASSED  " : "FAILED  ") << name << "\n";
+  return passed;
+}
+
+/*Windows that passed the cascade, without grouping (groupThreshold 0)*/
+static void scanWindows(CASCADE_CLASSIFIERS_EVALUATION & detector, const cv::Mat & image, const std::vector < SEARCH_REGION > & regions, std::vector < cv::Rect > & windows) {
+  cv::Mat copy = image.clone();
+  windows.clear();
+  detector.detectObjectRectanglesGroupedZeroDegrees(copy, NULL, & windows, false, false, & regions);
+}
+
+static bool checkCoarseToFine(CASCADE_CLASSIFIERS_EVALUATION & detector, const cv::Mat & image) {
+
+  bool passed = true;
+  detector.setGroupThreshold(0);
+
+  /*The origins are not multiples of the steps of the small scales*/
+  cv::Point origins[] = {cv::Point(0, 0), cv::Point(5, 3), cv::Point(1537, 769)};
+  for (int o = 0; o < 3; o++) {
+
+    std::vector < SEARCH_REGION > regions(1, SEARCH_REGION(cv::Rect(0, 0, image.cols, image.rows), 0, INT_MAX, origins[o]));
+    std::ostringstream name;
+    name << "coarse-to-fine, origin (" << origins[o].x << ", " << origins[o].y << ")";
+
+    std::vector < cv::Rect > dense, coarse;
+    detector.setFlagCoarseToFine(false);
+    scanWindows(detector, image, regions, dense);
+
+    detector.setFlagCoarseToFine(true);
+    detector.setCoarseStep(1);
+    detector.setRefinementRadius(0);
+    scanWindows(detector, image, regions, coarse);
+    std::ostringstream windows;
+    windows << dense.size();
+    passed = report(name.str() + ", coarse step 1 finds the windows of the normal scan (" + windows.str() + " windows)", coarse == dense) && passed;
+
+    detector.setCoarseStep(2);
+    detector.setRefinementRadius(1);
+    scanWindows(detector, image, regions, coarse);
+    passed = report(name.str() + ", coarse step 2 subset of the normal scan", isSubset(coarse, dense)) && passed;
+
+  }
+
+  detector.setFlagCoarseToFine(false);
+  return passed;
+}
+
+static void writeFile(const std::string & nameFile, const std::vector < char > & data) {
+  std::ofstream file(nameFile.c_str(), std::ios::binary);
+  file.write( & data[0], data.size());
+}
+
+/*Replaces the int at offset of data*/
+static void writeInt(std::vector < char > & data, long offset, int value) {
+  std::memcpy( & data[offset], & value, sizeof(value));
+}
+
+static bool checkBinaryCascade(CASCADE_CLASSIFIERS_EVALUATION & detector, const cv::Mat & image) {
+
+  bool passed = true;
+  detector.setGroupThreshold(0);
+  const std::string nameBinary = "checkDetector.cascade.bin";
+
+  if (!report("binary cascade saved", detector.saveBinaryCascade(nameBinary))) return false;
+
+  std::vector < SEARCH_REGION > regions(1, SEARCH_REGION(cv::Rect(0, 0, image.cols, image.rows), 0, INT_MAX));
+  std::vector < cv::Rect > windows, windowsBinary;
+  scanWindows(detector, image, regions, windows);
+  {
+    CASCADE_CLASSIFIERS_EVALUATION binary(nameBinary);
+    binary.setFlagParallelScan(false);
+    binary.setGroupThreshold(0);
+    passed = report("binary cascade has the same stages", binary.getNumberStrongLearns() == detector.getNumberStrongLearns()) && passed;
+    scanWindows(binary, image, regions, windowsBinary);
+    passed = report("binary cascade finds the same windows", windowsBinary == windows) && passed;
+  }
+
+  std::ifstream file(nameBinary.c_str(), std::ios::binary);
+  std::vector < char > data((std::istreambuf_iterator < char > (file)), std::istreambuf_iterator < char > ());
+  file.close();
+
+  /*The layout of writeBinary: a header of 8 characters and 8 ints, stageTreeBegin (stages + 1 ints), stageThreshold (stages doubles) and
+  treeRoot (one int per tree)*/
+  int stages = detector.getNumberStrongLearns();
+  long offsetStageTreeBegin = 8 + 8 * sizeof(int);
+  long offsetTreeRoot = offsetStageTreeBegin + (stages + 1) * sizeof(int) + stages * sizeof(double);
+
+  std::vector < std::string > names;
+  std::vector < std::vector < char > > corrupted;
+
+  names.push_back("truncated binary cascade rejected");
+  corrupted.push_back(std::vector < char > (data.begin(), data.begin() + data.size() / 2));
+
+  names.push_back("binary cascade with a stage outside the trees rejected");
+  corrupted.push_back(data);
+  writeInt(corrupted.back(), offsetStageTreeBegin + stages * sizeof(int), INT_MAX);
+
+  names.push_back("binary cascade with a tree root outside the nodes rejected");
+  corrupted.push_back(data);
+  writeInt(corrupted.back(), offsetTreeRoot, INT_MAX);
+
+  for (int c = 0; c < corrupted.size(); c++) {
+    writeFile(nameBinary, corrupted[c]);
+    CASCADE_CLASSIFIERS_EVALUATION binary(nameBinary);
+    passed = report(names[c], binary.getNumberStrongLearns() == 0) && passed;
+  }
+
+  std::remove(nameBinary.c_str());
+  return passed;
+}
+
+int main(int argc, char * argv[]) {
+
+  if (argc != 3) {
+    std::cout << "Usage: " << argv[0] << " <cascade file> <image>\n";
+    return 1;
+  }
+
+  std::string nameCascade = argv[1];
+  cv::Mat image = cv::imread(argv[2], 1);
+  if (image.empty()) {
+    std::cout << "The image " << argv[2] << " could not be read\n";
+    return 1;
+  }
+
+  CASCADE_CLASSIFIERS_EVALUATION detector(nameCascade);
+  if (detector.getNumberStrongLearns() == 0) {
+    std::cout << "No strong classifier was read from " << nameCascade << "\n";
+    return 1;
+  }
+  detector.setFlagParallelScan(false);
+
+  bool passed = true;
+  passed = checkCoarseToFine(detector, image) && passed;
+  passed = checkBinaryCascade(detector, image) && passed;
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/***************************************************************************
+**                                                                        **
+**  This source code is part of UVface++, a system developed by           **
+**  Roger Figueroa Quintero as part of his undergraduate thesis titled:   **
+**  "Image Analysis System for Face Detection and Recognition"            **
+**  at Universidad del Valle, Cali, Colombia.                             **
+**                                                                        **
+**  Copyright (C) 2016-2024 Roger Figueroa Quintero                       **
+**                                                                        **
+**  This software is licensed for non-commercial use only. Redistribution **
+**  and use in source and binary forms, with or without modification, are **
+**  permitted provided that the following conditions are met:             **
+**                                                                        **
+**  1. Redistributions of source code must retain the above copyright     **
+**     notice, this list of conditions, and the following disclaimer.     **
+**  2. Redistributions in binary form must reproduce the above copyright  **
+**     notice, this list of conditions, and the following disclaimer in   **
+**     the documentation and/or other materials provided with the         **
+**     distribution.                                                      **
+**  3. The name of the author may not be used to endorse or promote       **
+**     products derived from this software without specific prior written **
+**     permission.                                                        **
+**  4. This software is to be used for non-commercial purposes only.      **
+**                                                                        **
+**  This software is distributed in the hope that it will be useful, but  **
+**  WITHOUT ANY WARRANTY; without even the implied warranty of            **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                  **
+**                                                                        **
+****************************************************************************
+**           Author: Roger Figueroa Quintero                              **
+**  Contact Email: roggerfq@hotmail.com                                   **
+**          Date: First developed: November 2016                          **
+**                Last modified: December 2024                            **
+****************************************************************************/
+
+
+/*
+Converts a cascade in XML (the format of the files in cascading_classifiers) into the binary format of
+CASCADE_CLASSIFIERS_EVALUATION::saveBinaryCascade. The detector accepts both files, but the binary one is mapped and copied
+instead of parsed, so it loads much faster:
+
+  convertCascadeToBinary cascade.xml cascade.bin
+*/
+
+#include "detector.h"
+
+int main(int argc, char * argv[]) {
+
+  if (argc != 3) {
+    std::cout << "Usage: " << argv[0] << " <cascade file> <binary cascade file>\n";
+    return 1;
+  }
+
+  CASCADE_CLASSIFIERS_EVALUATION cascade(argv[1]);
+  if (cascade.getNumberStrongLearns() == 0) {
+    std::cout << "No strong classifier was read from " << argv[1] << "\n";
+    return 1;
+  }
+
+  if (!cascade.saveBinaryCascade(argv[2])) {
+    std::cout << "The file " << argv[2] << " could not be written\n";
+    return 1;
+  }
+
+  std::cout << cascade.getNumberStrongLearns() << " strong classifiers written to " << argv[2] << "\n";
+
+  return 0;
+}
@@ -0,0 +1,246 @@
+/***************************************************************************
+**                                                                        **
+**  This source code is part of UVface++, a system developed by           **
+**  Roger Figueroa Quintero as part of his undergraduate thesis titled:   **
+**  "Image Analysis System for Face Detection and Recognition"            **
+**  at Universidad del Valle, Cali, Colombia.                             **
+**                                                                        **
+**  Copyright (C) 2016-2024 Roger Figueroa Quintero                       **
+**                                                                        **
+**  This software is licensed for non-commercial use only. Redistribution **
+**  and use in source and binary forms, with or without modification, are **
+**  permitted provided that the following conditions are met:             **
+**                                                                        **
+**  1. Redistributions of source code must retain the above copyright     **
+**     notice, this list of conditions, and the following disclaimer.     **
+**  2. Redistributions in binary form must reproduce the above copyright  **
+**     notice, this list of conditions, and the following disclaimer in   **
+**     the documentation and/or other materials provided with the         **
+**     distribution.                                                      **
+**  3. The name of the author may not be used to endorse or promote       **
+**     products derived from this software without specific prior written **
+**     permission.                                                        **
+**  4. This software is to be used for non-commercial purposes only.      **
+**                                                                        **
+**  This software is distributed in the hope that it will be useful, but  **
+**  WITHOUT ANY WARRANTY; without even the implied warranty of            **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                  **
+**                                                                        **
+****************************************************************************
+**           Author: Roger Figueroa Quintero                              **
+**  Contact Email: roggerfq@hotmail.com                                   **
+**          Date: First developed: November 2016                          **
+**                Last modified: December 2024                            **
+****************************************************************************/
+
+
+/*
+Runs the FDDB detection function (CASCADE_CLASSIFIERS_EVALUATION::FDDB_detectObjectRectanglesGroupedZeroDegrees) on a set of images
+without the GUI and writes the detections in the format of the FDDB evaluation software (http://vis-www.cs.umass.edu/fddb/). The images
+are either an FDDB list (one name per line, relative to -base and without the .jpg extension) or every image of a directory:
+
+  detectFDDB cascade.xml FDDB-fold-01.txt detections.txt -base originalPics
+  detectFDDB cascade.xml frames/ detections.txt -ellipse -threads 8
+
+The images are split among OpenMP threads that share one detector, each one with its own DETECTION_CONTEXT, and at the end the images per second, the windows per second,
+the rejection rate of each stage and the memory used by the cascade and the contexts are printed.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <omp.h>
+#include "detector.h"
+
+#if EVALUATION_FDDB == 0
+#error "detectFDDB needs EVALUATION_FDDB set to 1 in detector.h"
+#endif
+
+static bool isDirectory(const std::string & path) {
+  struct stat information;
+  return stat(path.c_str(), & information) == 0 && S_ISDIR(information.st_mode);
+}
+
+static bool isImageFile(std::string name) {
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  const char * extensions[] = {".jpg", ".jpeg", ".png", ".bmp", ".pgm", ".ppm"};
+  for (int k = 0; k < 6; k++) {
+    std::string extension(extensions[k]);
+    if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0) return true;
+  }
+  return false;
+}
+
+int main(int argc, char * argv[]) {
+
+  if (argc < 4) {
+    std::cout << "Usage: " << argv[0] << " <cascade file> <FDDB list | directory> <output file> [options]\n";
+    std::cout << "  -base <directory>   Directory of the names of the FDDB list (.jpg is appended to them)\n";
+    std::cout << "  -ellipse            Writes ellipses instead of rectangles\n";
+    std::cout << "  -threads <n>        Number of threads (by default all the cores)\n";
+    std::cout << "  -sizeBase <n>       Smallest side of the search window\n";
+    std::cout << "  -factorScale <f>    Factor between consecutive scales\n";
+    std::cout << "  -step <f>           Step of the window, relative to its side\n";
+    std::cout << "  -sizeMax <n>        Largest side of the search window\n";
+    std::cout << "  -noDouble           Does not double the list of candidates before grouping them\n";
+    return 1;
+  }
+
+  std::string nameCascade = argv[1];
+  std::string input = argv[2];
+  std::string nameOutput = argv[3];
+
+  //____________________Options____________________//
+  std::string base;
+  bool ellipses = false;
+  bool doubleDetectedList = true;
+  int numberThreads = omp_get_max_threads();
+  int sizeBase = -1;
+  double factorScale = -1;
+  double step = -1;
+  int sizeMax = -1;
+
+  for (int k = 4; k < argc; k++) {
+    std::string option = argv[k];
+    bool hasValue = (k + 1 < argc);
+    if (option == "-base" && hasValue) base = argv[++k];
+    else if (option == "-ellipse") ellipses = true;
+    else if (option == "-noDouble") doubleDetectedList = false;
+    else if (option == "-threads" && hasValue) numberThreads = std::max(1, std::atoi(argv[++k]));
+    else if (option == "-sizeBase" && hasValue) sizeBase = std::atoi(argv[++k]);
+    else if (option == "-factorScale" && hasValue) factorScale = std::atof(argv[++k]);
+    else if (option == "-step" && hasValue) step = std::atof(argv[++k]);
+    else if (option == "-sizeMax" && hasValue) sizeMax = std::atoi(argv[++k]);
+    else {
+      std::cout << "Unknown option " << option << "\n";
+      return 1;
+    }
+  }
+  //_______________________________________________//
+
+  //____________________Images____________________//
+  std::vector < std::string > names; //Names written in the output
+  std::vector < std::string > paths; //Files read
+  if (isDirectory(input)) {
+    DIR * directory = opendir(input.c_str());
+    for (struct dirent * entry = readdir(directory); entry != NULL; entry = readdir(directory))
+      if (isImageFile(entry -> d_name)) names.push_back(entry -> d_name);
+    closedir(directory);
+    std::sort(names.begin(), names.end());
+    for (int k = 0; k < names.size(); k++)
+      paths.push_back(input + "/" + names[k]);
+  } else {
+    std::ifstream list(input.c_str());
+    if (!list) {
+      std::cout << "The file " << input << " could not be opened\n";
+      return 1;
+    }
+    std::string name;
+    while (std::getline(list, name)) {
+      if (!name.empty() && name[name.size() - 1] == '\r') name.erase(name.size() - 1);
+      if (name.empty()) continue;
+      names.push_back(name);
+      paths.push_back((base.empty() ? name : base + "/" + name) + ".jpg");
+    }
+  }
+
+  if (names.empty()) {
+    std::cout << "There are no images in " << input << "\n";
+    return 1;
+  }
+  //______________________________________________//
+
+  //____________________Detector, shared by all the threads____________________//
+  CASCADE_CLASSIFIERS_EVALUATION detector(nameCascade);
+  if (detector.getNumberStrongLearns() == 0) {
+    std::cout << "No strong classifier was read from " << nameCascade << "\n";
+    return 1;
+  }
+  if (sizeBase > 0) detector.setSizeBase(sizeBase);
+  if (factorScale > 1) detector.setFactorScaleWindow(factorScale);
+  if (step > 0) detector.setStepWindow(step);
+  if (sizeMax > 0) detector.setSizeMaxWindow(sizeMax);
+  detector.setFlagParallelScan(false); // The parallelism is between images
+  detector.initializeFeatures();
+
+  std::vector < DETECTION_CONTEXT > contexts(numberThreads); // The scratch buffers of each thread
+  //___________________________________________________________________________//
+
+  std::vector < std::string > results(names.size()); //Text of each image in the output
+  int skipped = 0;
+
+  double start = cv::getTickCount();
+
+  #pragma omp parallel for schedule(dynamic) num_threads(numberThreads) reduction(+: skipped)
+  for (int k = 0; k < (int) names.size(); k++) {
+
+    DETECTION_CONTEXT & context = contexts[omp_get_thread_num()];
+
+    cv::Mat image = cv::imread(paths[k], 1);
+    if (image.empty()) {
+      skipped++;
+      continue;
+    }
+
+    std::vector < cv::Rect > rectangles;
+    std::vector < double > scores;
+    detector.FDDB_detectObjectRectanglesGroupedZeroDegrees(context, image, rectangles, scores, doubleDetectedList);
+
+    std::ostringstream text;
+    text << names[k] << "\n" << rectangles.size() << "\n";
+    for (int i = 0; i < rectangles.size(); i++) {
+      const cv::Rect & r = rectangles[i];
+      if (ellipses) // The ellipse inscribed in the rectangle with its major axis vertical, as the faces annotated in FDDB
+        text << r.height / 2.0 << " " << r.width / 2.0 << " " << M_PI / 2 << " " << r.x + r.width / 2.0 << " " << r.y + r.height / 2.0 << " " << scores[i] << "\n";
+      else
+        text << r.x << " " << r.y << " " << r.width << " " << r.height << " " << scores[i] << "\n";
+    }
+    results[k] = text.str();
+
+  }
+
+  double seconds = (cv::getTickCount() - start) / cv::getTickFrequency();
+
+  std::ofstream output(nameOutput.c_str());
+  if (!output) {
+    std::cout << "The file " << nameOutput << " could not be written\n";
+    return 1;
+  }
+  for (int k = 0; k < results.size(); k++)
+    output << results[k];
+
+  //____________________Report____________________//
+  SCAN_STATISTICS statistics;
+  for (int t = 0; t < numberThreads; t++)
+    statistics.add(contexts[t].getScanStatistics());
+
+  int processed = names.size() - skipped;
+  std::cout << processed << " images in " << seconds << " s with " << numberThreads << " threads";
+  if (skipped > 0) std::cout << " (" << skipped << " images could not be read)";
+  std::cout << "\n";
+  std::cout << "Images per second: " << processed / seconds << "\n";
+
+  if (statistics.windows > 0) {
+    std::cout << "Windows per second: " << statistics.windows / seconds << " (" << statistics.windows << " windows)\n";
+    std::cout << "Stage\tWindows\tRejected\n";
+    long long entering = statistics.getWindowsEntering(0);
+    for (int s = 0; s < statistics.rejectedByStage.size() && entering > 0; s++) {
+      std::cout << s << "\t" << entering << "\t" << 100.0 * statistics.rejectedByStage[s] / entering << " %\n";
+      entering = entering - statistics.rejectedByStage[s];
+    }
+    std::cout << "Windows that passed the cascade: " << entering << "\n";
+  }
+
+  detector.reportMemory(std::cout);
+  size_t bytesContexts = 0;
+  for (int t = 0; t < numberThreads; t++)
+    bytesContexts = bytesContexts + contexts[t].getBytes();
+  std::cout << "Detection contexts: " << bytesContexts << " bytes (" << numberThreads << " threads)\n";
+  //______________________________________________//
+
+  return 0;
+}